@@ -0,0 +1,122 @@
+/*
+ * bench_color_lut.c
+ *
+ *  Cost of the color tables in the output path.  MAP_Apply() looks every
+ *  channel up in the output's 16 bit table while it moves the universe
+ *  into the level array, so the table costs what that copy costs over a
+ *  plain one.  Dithering down to 8 bits and the WS2812 bit encoding of the
+ *  same pixels follow, for scale.
+ *
+ *  cc -O2 -Isources bench/bench_color_lut.c sources/color_lut.c sources/pixel_map.c sources/dither.c \
+ *      sources/ws2812.c -lm -o bench_color_lut
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "color_lut.h"
+#include "dither.h"
+#include "pixel_map.h"
+#include "ws2812.h"
+
+#define PIXELS 170
+#define ROUNDS 20000
+
+static uint8_t src[1 + PIXELS * 3];
+static uint16_t levels[PIXELS * 3];
+static uint8_t residual[PIXELS * 3];
+static uint8_t dst[PIXELS * 3];
+static uint16_t cnv[WS2812_BUFFER_ENTRIES(PIXELS * 3)];
+static color_lut16_t lut;
+static map_plan_t plan;
+static volatile uint32_t sink;
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* The same move without tables: RGB to GRB, widened to 16 bits */
+static void copy_plain(void)
+{
+    const uint8_t *s = src + 1;
+    uint16_t *d = levels;
+    int i;
+
+    for (i = 0; i < PIXELS; i++) {
+        d[0] = (uint16_t)(s[1] * 257);
+        d[1] = (uint16_t)(s[0] * 257);
+        d[2] = (uint16_t)(s[2] * 257);
+        s += 3;
+        d += 3;
+    }
+}
+
+/* What output.c does per universe */
+static void map_apply(void)
+{
+    static const color_lut16_t *const luts[1] = { &lut };
+    static uint16_t *const out[1] = { levels };
+
+    MAP_Apply(&plan, 1, src + 1, PIXELS * 3, luts, out);
+}
+
+static void dither(void)
+{
+    DITHER_Apply(levels, residual, PIXELS * 3, DITHER_UNITY, dst);
+}
+
+static ws2812_timing_t timing;
+
+static void encode(void)
+{
+    sink += (uint32_t)WS2812_Encode(&timing, dst, sizeof(dst), cnv);
+}
+
+static double run(void (*fn)(void))
+{
+    double t;
+    int r;
+
+    t = now();
+    for (r = 0; r < ROUNDS; r++) {
+        src[1 + r % (sizeof(src) - 1)] = (uint8_t)r;
+        fn();
+        sink += levels[r % PIXELS] + dst[r % sizeof(dst)];
+    }
+    return (now() - t) / ROUNDS;
+}
+
+int main(void)
+{
+    color_correction_t cc = { 2.2f, { 255, 220, 180, 255 } };
+    map_output_t output = { 1, 1, PIXELS, PIXELS, 0, MAP_ORDER_GRB, 0, 0 };
+    double plain, table, dith, enc;
+    size_t i;
+
+    for (i = 1; i < sizeof(src); i++)
+        src[i] = (uint8_t)(i * 37);
+    COLORLUT_Build16(&lut, &cc);
+    if (MAP_Compile(&plan, &output, 1)) {
+        printf("map does not compile\n");
+        return 1;
+    }
+    WS2812_GetTiming(&timing, kWS2812_TypeWS2812, 60000000U);
+
+    plain = run(copy_plain);
+    table = run(map_apply);
+    dith = run(dither);
+    enc = run(encode);
+
+    printf("per universe (%d pixels):\n", PIXELS);
+    printf("  copy          %8.1f ns\n", plain);
+    printf("  MAP_Apply     %8.1f ns\n", table);
+    printf("  dither        %8.1f ns\n", dith);
+    printf("  ws2812 encode %8.1f ns\n", enc);
+    printf("  lut overhead  %8.1f ns, %.1f%% of map + dither + encode\n", table - plain,
+           100.0 * (table - plain) / (table + dith + enc));
+    return 0;
+}
@@ -0,0 +1,105 @@
+/*
+ * bench_e131.c
+ *
+ *  Cost of the E1.31 receive path per packet: validation alone, then the
+ *  whole parse of full universes (validate, sequence and priority checks,
+ *  the slot copy and the latch) rotating over the universe table, and the
+ *  rejection of duplicates.
+ *
+ *  cc -O2 -Isources bench/bench_e131.c sources/E131.c -o bench_e131
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "E131.h"
+
+#define ROUNDS 200000
+
+static uint8_t packets[E131_DEFAULT_UNIVERSE_COUNT][sizeof(e131_packet_t)];
+static uint16_t size;
+static volatile uint32_t sink;
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+uint32_t E131_now(void)
+{
+    return (uint32_t)(now() / 1e6);
+}
+
+static void received(e131_universe_t *u)
+{
+    sink += u->data[1];
+}
+
+static void build(uint8_t *p, uint16_t universe)
+{
+    static const uint8_t acn[12] = { 0x41, 0x53, 0x43, 0x2d, 0x45, 0x31, 0x2e, 0x31, 0x37, 0x00, 0x00, 0x00 };
+    int i;
+
+    size = E131_DMP_DATA + E131_UNIVERSE_SIZE;
+    memset(p, 0, sizeof(e131_packet_t));
+    p[1] = 0x10;
+    memcpy(p + E131_ROOT_ID, acn, sizeof(acn));
+    p[E131_ROOT_FLENGTH] = (uint8_t)(0x70 | (size - E131_ROOT_FLENGTH) >> 8);
+    p[E131_ROOT_FLENGTH + 1] = (uint8_t)(size - E131_ROOT_FLENGTH);
+    p[E131_ROOT_VECTOR + 3] = 4;
+    memset(p + E131_ROOT_CID, 0x5a, 16);
+    p[E131_FRAME_FLENGTH] = (uint8_t)(0x70 | (size - E131_FRAME_FLENGTH) >> 8);
+    p[E131_FRAME_FLENGTH + 1] = (uint8_t)(size - E131_FRAME_FLENGTH);
+    p[E131_FRAME_VECTOR + 3] = 2;
+    p[E131_FRAME_PRIORITY] = E131_PRIORITY_DEFAULT;
+    p[E131_FRAME_UNIVERSE] = (uint8_t)(universe >> 8);
+    p[E131_FRAME_UNIVERSE + 1] = (uint8_t)universe;
+    p[E131_DMP_FLENGTH] = (uint8_t)(0x70 | (size - E131_DMP_FLENGTH) >> 8);
+    p[E131_DMP_FLENGTH + 1] = (uint8_t)(size - E131_DMP_FLENGTH);
+    p[E131_DMP_VECTOR] = 2;
+    p[E131_DMP_TYPE] = 0xa1;
+    p[E131_DMP_ADDR_INC + 1] = 1;
+    p[E131_DMP_COUNT] = (uint8_t)(E131_UNIVERSE_SIZE >> 8);
+    p[E131_DMP_COUNT + 1] = (uint8_t)E131_UNIVERSE_SIZE;
+    for (i = 1; i < E131_UNIVERSE_SIZE; i++)
+        p[E131_DMP_DATA + i] = (uint8_t)(i * 7 + universe);
+}
+
+int main(void)
+{
+    double t, valid, parse, dup;
+    int r, n;
+
+    E131_init();
+    E131_setCallback(received);
+    for (n = 0; n < E131_DEFAULT_UNIVERSE_COUNT; n++)
+        build(packets[n], (uint16_t)(E131_DEFAULT_UNIVERSE + n));
+
+    t = now();
+    for (r = 0; r < ROUNDS; r++)
+        sink += validate((const e131_packet_t *)packets[r % E131_DEFAULT_UNIVERSE_COUNT], size);
+    valid = (now() - t) / ROUNDS;
+
+    t = now();
+    for (r = 0; r < ROUNDS; r++) {
+        n = r % E131_DEFAULT_UNIVERSE_COUNT;
+        packets[n][E131_FRAME_SEQ]++;
+        sink += E131_parseBuffer(packets[n], size);
+    }
+    parse = (now() - t) / ROUNDS;
+
+    t = now();
+    for (r = 0; r < ROUNDS; r++)
+        sink += E131_parseBuffer(packets[r % E131_DEFAULT_UNIVERSE_COUNT], size);
+    dup = (now() - t) / ROUNDS;
+
+    printf("per packet (512 slots, %d universes):\n", E131_DEFAULT_UNIVERSE_COUNT);
+    printf("  validate      %8.1f ns\n", valid);
+    printf("  parse + latch %8.1f ns, %.0f packets/s\n", parse, 1e9 / parse);
+    printf("  duplicate     %8.1f ns\n", dup);
+    return 0;
+}
@@ -0,0 +1,108 @@
+/*
+ * bench_transpose.c
+ *
+ *  Cost of the bit-plane transposition of one parallel frame, the kernels
+ *  against the naive loop that tests every bit of every strand.  A frame
+ *  is WS2812PORT_MAX_PIXELS GRB pixels per strand.
+ *
+ *  cc -O2 -Isources bench/bench_transpose.c sources/pixel_transpose.c -o bench_transpose
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "pixel_transpose.h"
+
+#define BYTES (340 * 3)  /* WS2812PORT_MAX_PIXELS GRB pixels */
+#define ROUNDS 2000
+
+static uint8_t src[16 * BYTES];
+static uint8_t p8[BYTES * 8];
+static uint16_t p16[BYTES * 8];
+static volatile uint32_t sink;
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Bit by bit, as a plain loop would build the planes */
+static void naive8(void)
+{
+    size_t i;
+    int b, s;
+    uint8_t v;
+
+    for (i = 0; i < BYTES; i++) {
+        for (b = 0; b < 8; b++) {
+            v = 0;
+            for (s = 0; s < 8; s++)
+                v |= (uint8_t)(((src[s * BYTES + i] >> (7 - b)) & 1U) << s);
+            p8[i * 8 + b] = v;
+        }
+    }
+}
+
+static void naive16(void)
+{
+    size_t i;
+    int b, s;
+    uint16_t v;
+
+    for (i = 0; i < BYTES; i++) {
+        for (b = 0; b < 8; b++) {
+            v = 0;
+            for (s = 0; s < 16; s++)
+                v |= (uint16_t)(((src[s * BYTES + i] >> (7 - b)) & 1U) << s);
+            p16[i * 8 + b] = v;
+        }
+    }
+}
+
+static void kernel8(void)
+{
+    PIXEL_Transpose8(src, BYTES, BYTES, p8);
+}
+
+static void kernel16(void)
+{
+    PIXEL_Transpose16(src, BYTES, BYTES, p16);
+}
+
+static double run(void (*fn)(void))
+{
+    double t;
+    int r;
+
+    t = now();
+    for (r = 0; r < ROUNDS; r++) {
+        src[r % sizeof(src)] = (uint8_t)r;
+        fn();
+        sink += p8[r % sizeof(p8)] + p16[r % (sizeof(p16) / 2)];
+    }
+    return (now() - t) / ROUNDS;
+}
+
+int main(void)
+{
+    double n8, k8, n16, k16;
+    size_t i;
+
+    for (i = 0; i < sizeof(src); i++)
+        src[i] = (uint8_t)(i * 37 + (i >> 7));
+
+    n8 = run(naive8);
+    k8 = run(kernel8);
+    n16 = run(naive16);
+    k16 = run(kernel16);
+
+    printf("per frame (%d bytes per strand):\n", BYTES);
+    printf("   8 strands naive  %10.1f ns\n", n8);
+    printf("   8 strands kernel %10.1f ns, %.1fx\n", k8, n8 / k8);
+    printf("  16 strands naive  %10.1f ns\n", n16);
+    printf("  16 strands kernel %10.1f ns, %.1fx\n", k16, n16 / k16);
+    return 0;
+}
@@ -5,27 +5,75 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
 ../sources/E131.c \
+../sources/E131_lwip.c \
+../sources/apa102.c \
+../sources/apa102_spi.c \
 ../sources/board.c \
 ../sources/clock_config.c \
+../sources/color_lut.c \
+../sources/dither.c \
+../sources/dma_chan.c \
+../sources/dmx_uart.c \
 ../sources/fsl_phy.c \
+../sources/interp.c \
+../sources/loss.c \
 ../sources/main.c \
-../sources/pin_mux.c 
+../sources/output.c \
+../sources/pin_mux.c \
+../sources/pixel_map.c \
+../sources/pixel_transpose.c \
+../sources/power.c \
+../sources/ws2812.c \
+../sources/ws2812_ftm.c \
+../sources/ws2812_port.c 
 
 OBJS += \
 ./sources/E131.o \
+./sources/E131_lwip.o \
+./sources/apa102.o \
+./sources/apa102_spi.o \
 ./sources/board.o \
 ./sources/clock_config.o \
+./sources/color_lut.o \
+./sources/dither.o \
+./sources/dma_chan.o \
+./sources/dmx_uart.o \
 ./sources/fsl_phy.o \
+./sources/interp.o \
+./sources/loss.o \
 ./sources/main.o \
-./sources/pin_mux.o 
+./sources/output.o \
+./sources/pin_mux.o \
+./sources/pixel_map.o \
+./sources/pixel_transpose.o \
+./sources/power.o \
+./sources/ws2812.o \
+./sources/ws2812_ftm.o \
+./sources/ws2812_port.o 
 
 C_DEPS += \
 ./sources/E131.d \
+./sources/E131_lwip.d \
+./sources/apa102.d \
+./sources/apa102_spi.d \
 ./sources/board.d \
 ./sources/clock_config.d \
+./sources/color_lut.d \
+./sources/dither.d \
+./sources/dma_chan.d \
+./sources/dmx_uart.d \
 ./sources/fsl_phy.d \
+./sources/interp.d \
+./sources/loss.d \
 ./sources/main.d \
-./sources/pin_mux.d 
+./sources/output.d \
+./sources/pin_mux.d \
+./sources/pixel_map.d \
+./sources/pixel_transpose.d \
+./sources/power.d \
+./sources/ws2812.d \
+./sources/ws2812_ftm.d \
+./sources/ws2812_port.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
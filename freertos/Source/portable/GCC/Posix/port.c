@@ -0,0 +1,324 @@
+/*
+    FreeRTOS V9.0.0 POSIX port
+
+    Port of the FreeRTOS V9.0.0 kernel in this tree to POSIX threads, for
+    running the firmware as a Linux process (sim/).  Distributed under the
+    same license as the kernel: the GNU General Public License (version 2)
+    with the FreeRTOS exception, see http://www.freertos.org/a00114.html
+
+    1 tab == 4 spaces!
+*/
+
+/*-----------------------------------------------------------
+ * Implementation of functions defined in portable.h for POSIX threads.
+ *
+ * Each task runs in a pthread that waits on its own run flag.  A context
+ * switch sets the run flag of the thread of the new pxCurrentTCB and makes
+ * the old thread wait on its own, so exactly one task thread runs at a time.
+ *
+ * The tick is SIGALRM from ITIMER_REAL.  Every thread but the running task
+ * keeps it blocked, so it interrupts the running task the way SysTick
+ * interrupts the CPU, and a critical section is the signal blocked in that
+ * thread.  The critical nesting count is per task: it is kept on the stack
+ * of a thread across each switch.
+ *
+ * Library calls that take locks of their own (stdio, ...) must not be
+ * preempted by the tick, or the next task may wait on a lock held by a
+ * thread that does not run: make them in a critical section, as heap_3
+ * does for malloc() by suspending the scheduler.
+ *----------------------------------------------------------*/
+
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define portTICK_SIGNAL		SIGALRM
+
+/* A task's thread, kept at the top of its FreeRTOS stack */
+typedef struct THREAD
+{
+	pthread_t xThread;
+	pthread_mutex_t xMutex;
+	pthread_cond_t xCond;
+	BaseType_t xRun;				/* Set to let the thread run, cleared as it does */
+	volatile BaseType_t xDying;		/* Deleted, the thread exits as soon as it wakes */
+	TaskFunction_t pxCode;
+	void *pvParams;
+} Thread_t;
+
+static sigset_t xTickSignal;
+static volatile UBaseType_t uxCriticalNesting = 0;
+
+/* The main thread waits here while the scheduler runs */
+static pthread_mutex_t xEndMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t xEndCond = PTHREAD_COND_INITIALIZER;
+static BaseType_t xSchedulerEnded = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+static Thread_t *prvGetThreadFromTask( TaskHandle_t xTask )
+{
+	/* pxTopOfStack, the first member of the TCB, is what pxPortInitialiseStack() returned */
+	return *( Thread_t ** ) xTask;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSuspendSelf( Thread_t *pxThread )
+{
+	pthread_mutex_lock( &pxThread->xMutex );
+	while( pxThread->xRun == pdFALSE )
+	{
+		pthread_cond_wait( &pxThread->xCond, &pxThread->xMutex );
+	}
+	pxThread->xRun = pdFALSE;
+	pthread_mutex_unlock( &pxThread->xMutex );
+}
+/*-----------------------------------------------------------*/
+
+static void prvResumeThread( Thread_t *pxThread )
+{
+	pthread_mutex_lock( &pxThread->xMutex );
+	pxThread->xRun = pdTRUE;
+	pthread_cond_signal( &pxThread->xCond );
+	pthread_mutex_unlock( &pxThread->xMutex );
+}
+/*-----------------------------------------------------------*/
+
+/* Hand the CPU from the calling thread to another, called with the tick blocked */
+static void prvSwitchThread( Thread_t *pxThreadToResume, Thread_t *pxThreadToSuspend )
+{
+	UBaseType_t uxSavedCriticalNesting;
+
+	if( pxThreadToSuspend != pxThreadToResume )
+	{
+		uxSavedCriticalNesting = uxCriticalNesting;
+
+		prvResumeThread( pxThreadToResume );
+		if( pxThreadToSuspend->xDying != pdFALSE )
+		{
+			pthread_exit( NULL );
+		}
+
+		prvSuspendSelf( pxThreadToSuspend );
+		if( pxThreadToSuspend->xDying != pdFALSE )
+		{
+			pthread_exit( NULL );
+		}
+
+		uxCriticalNesting = uxSavedCriticalNesting;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void *prvWaitForStart( void *pvParams )
+{
+	Thread_t *pxThread = ( Thread_t * ) pvParams;
+
+	prvSuspendSelf( pxThread );
+	if( pxThread->xDying != pdFALSE )
+	{
+		return NULL;
+	}
+
+	/* First run of the task, outside any critical section */
+	uxCriticalNesting = 0;
+	vPortEnableInterrupts();
+	pxThread->pxCode( pxThread->pvParams );
+
+	/* Tasks must not return */
+	configASSERT( pdFALSE );
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTickHandler( int iSignal )
+{
+	Thread_t *pxThreadToSuspend;
+
+	( void ) iSignal;
+
+	/* The signal stays blocked while its handler runs */
+	uxCriticalNesting++;
+
+	pxThreadToSuspend = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+	if( xTaskIncrementTick() != pdFALSE )
+	{
+		vTaskSwitchContext();
+	}
+	prvSwitchThread( prvGetThreadFromTask( xTaskGetCurrentTaskHandle() ), pxThreadToSuspend );
+
+	uxCriticalNesting--;
+}
+/*-----------------------------------------------------------*/
+
+StackType_t *pxPortInitialiseStack( StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters )
+{
+	Thread_t *pxThread;
+	sigset_t xSaved;
+	int iResult;
+
+	/* pxTopOfStack is the last word of the stack, aligned to portBYTE_ALIGNMENT */
+	pxThread = ( Thread_t * ) ( pxTopOfStack + 1 ) - 1;
+	memset( pxThread, 0, sizeof( *pxThread ) );
+	pxThread->pxCode = pxCode;
+	pxThread->pvParams = pvParameters;
+	pthread_mutex_init( &pxThread->xMutex, NULL );
+	pthread_cond_init( &pxThread->xCond, NULL );
+
+	/* The new thread inherits the mask, it takes no tick before its first run */
+	pthread_sigmask( SIG_BLOCK, &xTickSignal, &xSaved );
+	iResult = pthread_create( &pxThread->xThread, NULL, prvWaitForStart, pxThread );
+	pthread_sigmask( SIG_SETMASK, &xSaved, NULL );
+	configASSERT( iResult == 0 );
+	( void ) iResult;
+
+	return ( StackType_t * ) pxThread;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortStartScheduler( void )
+{
+	struct sigaction xAction;
+	struct itimerval xTimer;
+
+	/* The main thread never takes the tick, only task threads do.  Other
+	signals keep their default actions, so the process still stops on
+	SIGINT or SIGTERM. */
+	pthread_sigmask( SIG_BLOCK, &xTickSignal, NULL );
+
+	memset( &xAction, 0, sizeof( xAction ) );
+	xAction.sa_handler = prvTickHandler;
+	sigemptyset( &xAction.sa_mask );
+	xAction.sa_flags = SA_RESTART;
+	sigaction( portTICK_SIGNAL, &xAction, NULL );
+
+	xTimer.it_interval.tv_sec = 0;
+	xTimer.it_interval.tv_usec = 1000000L / configTICK_RATE_HZ;
+	xTimer.it_value = xTimer.it_interval;
+	setitimer( ITIMER_REAL, &xTimer, NULL );
+
+	/* Start the first task */
+	prvResumeThread( prvGetThreadFromTask( xTaskGetCurrentTaskHandle() ) );
+
+	pthread_mutex_lock( &xEndMutex );
+	while( xSchedulerEnded == pdFALSE )
+	{
+		pthread_cond_wait( &xEndCond, &xEndMutex );
+	}
+	pthread_mutex_unlock( &xEndMutex );
+
+	/* Only reached once vTaskEndScheduler() has been called */
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEndScheduler( void )
+{
+	struct itimerval xTimer;
+
+	memset( &xTimer, 0, sizeof( xTimer ) );
+	setitimer( ITIMER_REAL, &xTimer, NULL );
+
+	pthread_mutex_lock( &xEndMutex );
+	xSchedulerEnded = pdTRUE;
+	pthread_cond_signal( &xEndCond );
+	pthread_mutex_unlock( &xEndMutex );
+
+	/* The calling task does not run again, main() carries on */
+	for( ;; )
+	{
+		pause();
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortYield( void )
+{
+	Thread_t *pxThreadToSuspend;
+
+	vPortEnterCritical();
+
+	pxThreadToSuspend = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+	vTaskSwitchContext();
+	prvSwitchThread( prvGetThreadFromTask( xTaskGetCurrentTaskHandle() ), pxThreadToSuspend );
+
+	vPortExitCritical();
+}
+/*-----------------------------------------------------------*/
+
+void vPortDisableInterrupts( void )
+{
+	pthread_sigmask( SIG_BLOCK, &xTickSignal, NULL );
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnableInterrupts( void )
+{
+	pthread_sigmask( SIG_UNBLOCK, &xTickSignal, NULL );
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnterCritical( void )
+{
+	vPortDisableInterrupts();
+	uxCriticalNesting++;
+}
+/*-----------------------------------------------------------*/
+
+void vPortExitCritical( void )
+{
+	configASSERT( uxCriticalNesting );
+	uxCriticalNesting--;
+	if( uxCriticalNesting == 0 )
+	{
+		vPortEnableInterrupts();
+	}
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxPortSetInterruptMask( void )
+{
+	vPortEnterCritical();
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+void vPortClearInterruptMask( UBaseType_t uxMask )
+{
+	( void ) uxMask;
+	vPortExitCritical();
+}
+/*-----------------------------------------------------------*/
+
+void vPortThreadDying( void *pvTaskToDelete, volatile BaseType_t *pxPendYield )
+{
+	( void ) pxPendYield;
+	prvGetThreadFromTask( ( TaskHandle_t ) pvTaskToDelete )->xDying = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortCancelThread( void *pvTaskToDelete )
+{
+	Thread_t *pxThread = prvGetThreadFromTask( ( TaskHandle_t ) pvTaskToDelete );
+
+	/* Suspended or already gone: wake it to exit, then reap it before its stack is freed */
+	pxThread->xDying = pdTRUE;
+	prvResumeThread( pxThread );
+	pthread_join( pxThread->xThread, NULL );
+	pthread_cond_destroy( &pxThread->xCond );
+	pthread_mutex_destroy( &pxThread->xMutex );
+}
+/*-----------------------------------------------------------*/
+
+/* Runs before main(), so critical sections work before the scheduler starts */
+static void __attribute__( ( constructor ) ) prvPortInit( void )
+{
+	sigemptyset( &xTickSignal );
+	sigaddset( &xTickSignal, portTICK_SIGNAL );
+}
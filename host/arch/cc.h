@@ -0,0 +1,45 @@
+/*
+ * cc.h
+ *
+ *  lwIP compiler and platform definitions for the host tools and the Linux
+ *  build of the firmware (sim/).
+ */
+
+#ifndef __CC_H__
+#define __CC_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/time.h>
+
+/* The firmware's lwipopts.h leaves the integer types to the port */
+#if LWIP_NO_STDINT_H
+typedef uint8_t   u8_t;
+typedef int8_t    s8_t;
+typedef uint16_t  u16_t;
+typedef int16_t   s16_t;
+typedef uint32_t  u32_t;
+typedef int32_t   s32_t;
+typedef uintptr_t mem_ptr_t;
+#endif
+
+/* glibc has struct timeval, lwIP's sockets.h must not declare its own */
+#define LWIP_TIMEVAL_PRIVATE 0
+
+/* glibc defines it in stdlib.h already */
+#ifndef BYTE_ORDER
+#define BYTE_ORDER LITTLE_ENDIAN
+#endif
+
+/* The firmware's options name lwip_rand() in lwip/port/sys_arch.c */
+#ifndef LWIP_RAND
+#define LWIP_RAND() ((u32_t)rand())
+#else
+u32_t lwip_rand(void);
+#endif
+
+#define LWIP_PLATFORM_DIAG(x)   do { printf x; printf("\n"); } while (0)
+#define LWIP_PLATFORM_ASSERT(x) do { fprintf(stderr, "lwIP assertion \"%s\" failed at %s:%d\n", x, __FILE__, __LINE__); abort(); } while (0)
+
+#endif /* __CC_H__ */
@@ -0,0 +1,14 @@
+/*
+ * fsl_debug_console.h
+ *
+ *  The debug console of the host tools is stdout.
+ */
+
+#ifndef _FSL_DEBUG_CONSOLE_H_
+#define _FSL_DEBUG_CONSOLE_H_
+
+#include <stdio.h>
+
+#define PRINTF printf
+
+#endif /* _FSL_DEBUG_CONSOLE_H_ */
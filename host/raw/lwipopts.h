@@ -0,0 +1,43 @@
+/*
+ * lwipopts.h
+ *
+ *  lwIP configuration of the host tools: bare metal (NO_SYS) with the raw
+ *  API, UDP and IGMP only.  Frames are injected from captures whose
+ *  addresses are rewritten to the stand-in netif, so checksums are not
+ *  checked on input.
+ */
+
+#ifndef __LWIPOPTS_H__
+#define __LWIPOPTS_H__
+
+#define NO_SYS                          1
+#define LWIP_NETCONN                    0
+#define LWIP_SOCKET                     0
+#define SYS_LIGHTWEIGHT_PROT            0
+
+#define MEM_ALIGNMENT                   8
+#define MEM_SIZE                        (256 * 1024)
+#define MEMP_NUM_PBUF                   64
+#define MEMP_NUM_UDP_PCB                8
+#define MEMP_NUM_SYS_TIMEOUT            16
+#define PBUF_POOL_SIZE                  256
+#define PBUF_POOL_BUFSIZE               1536
+
+#define LWIP_ARP                        1
+#define LWIP_ETHERNET                   1
+#define LWIP_ICMP                       1
+#define LWIP_IGMP                       1
+#define LWIP_UDP                        1
+#define LWIP_TCP                        0
+#define LWIP_RAW                        0
+#define LWIP_DHCP                       0
+#define LWIP_AUTOIP                     0
+#define LWIP_DNS                        0
+#define LWIP_IPV6                       0
+#define LWIP_NETIF_LOOPBACK             0
+#define LWIP_STATS                      0
+
+#define CHECKSUM_CHECK_IP               0
+#define CHECKSUM_CHECK_UDP              0
+
+#endif /* __LWIPOPTS_H__ */
@@ -31,7 +31,9 @@
  */
 
 #include "udpecho.h"
-#include "E131.h"
+#include "E131_lwip.h"
+#include "output.h"
+#include "loss.h"
 
 #include "lwip/opt.h"
 
@@ -40,7 +42,8 @@
 #include "lwip/api.h"
 #include "lwip/sys.h"
 
-#include "lwip\netif.h"
+#include "lwip/netif.h"
+#include "ethernetif.h"
 
 
 /*-----------------------------------------------------------------------------------*/
@@ -52,7 +55,15 @@ udpecho_thread(void *arg)
 
 
   E131_init();
-  E131_begin(E131_UNICAST, 0, 0);
+  E131_setCallback(OUTPUT_Update);
+  E131_setLossCallback(LOSS_Update);
+
+  /* Multicast on the universes the outputs drive, unicast is received as well */
+#if E131_RAW_RECV
+  E131_beginRaw(E131_MULTICAST, OUTPUT_UNIVERSE, OUTPUT_RANGE_UNIVERSES);
+#else
+  E131_begin(E131_MULTICAST, OUTPUT_UNIVERSE, OUTPUT_RANGE_UNIVERSES);
+#endif
 
 
 /* Only for testing of multicast join*/
@@ -71,7 +82,20 @@ udpecho_thread(void *arg)
 
   while (1) {
 
+#if E131_RAW_RECV
+	/* Packets are handled in the tcpip thread, just report progress */
+	sys_msleep(1000);
+	{
+	  ethernetif_rx_stats_t rx;
+
+	  ethernetif_get_rx_stats(netif_default, &rx);
+	  PRINTF("PR: %d   PE: %d     SE: %d   RING: %d   POOL: %d   MBOX: %d   OVR: %d\r", stats.num_packets,
+	         stats.packet_errors, stats.sequence_errors, rx.ring_full, rx.pool_empty, rx.input_errors,
+	         rx.mac_overrun);
+	}
+#else
 	E131_parsePacket();
+#endif
 
 
     }
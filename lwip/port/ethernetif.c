@@ -35,6 +35,7 @@
 #include "lwip/def.h"
 #include "lwip/mem.h"
 #include "lwip/pbuf.h"
+#include "lwip/sys.h"
 #include "lwip/stats.h"
 #include "lwip/snmp.h"
 #include "lwip/ethip6.h"
@@ -46,6 +47,7 @@
 #if USE_RTOS && defined(FSL_RTOS_FREE_RTOS)
 #include "FreeRTOS.h"
 #include "event_groups.h"
+#include "task.h"
 #endif
 
 #include "ethernetif.h"
@@ -62,6 +64,21 @@
 
 #define ENET_ALIGN(x) ((unsigned int)((x) + ((ENET_BUFF_ALIGNMENT)-1)) & (unsigned int)(~(unsigned int)((ENET_BUFF_ALIGNMENT)-1)))
 
+#if ENET_RX_ZERO_COPY && (!LWIP_SUPPORT_CUSTOM_PBUF || ETH_PAD_SIZE)
+#error "ENET_RX_ZERO_COPY requires LWIP_SUPPORT_CUSTOM_PBUF and no ETH_PAD_SIZE"
+#endif
+
+#if ENET_RX_ZERO_COPY
+/**
+ * A receive DMA buffer lent to lwIP as a custom pbuf.
+ */
+struct rx_pbuf_wrapper{
+    struct pbuf_custom      p;          /* Must be first, lwIP casts back to it */
+    uint8_t                 *buffer;    /* The DMA buffer this pbuf refers to */
+    struct rx_pbuf_wrapper  *next;      /* Spare list link */
+};
+#endif
+
 /**
  * Helper struct to hold private data used to operate your ethernet interface.
  */
@@ -72,11 +89,22 @@ struct ethernetif{
 #if USE_RTOS && defined(FSL_RTOS_FREE_RTOS)
     EventGroupHandle_t  enetTransmitAccessEvent;
     EventBits_t         txFlag;
+    TaskHandle_t        rxTask;
 #endif
     uint8_t RxBuffDescrip[ENET_RXBD_NUM * sizeof(enet_rx_bd_struct_t) + ENET_BUFF_ALIGNMENT];
     uint8_t TxBuffDescrip[ENET_TXBD_NUM * sizeof(enet_tx_bd_struct_t) + ENET_BUFF_ALIGNMENT];
+#if ENET_RX_ZERO_COPY
+    /* The first ENET_RXBD_NUM buffers start out in the ring, the rest are spares. */
+    uint8_t RxDataBuff[ENET_RXBUFF_NUM * ENET_ALIGN(ENET_RXBUFF_SIZE) + ENET_BUFF_ALIGNMENT];
+    struct rx_pbuf_wrapper RxPbufs[ENET_RXBUFF_NUM];
+    struct rx_pbuf_wrapper *rxSpare;
+#else
     uint8_t RxDataBuff[ENET_RXBD_NUM * ENET_ALIGN(ENET_RXBUFF_SIZE) + ENET_BUFF_ALIGNMENT];
+#endif
     uint8_t TxDataBuff[ENET_TXBD_NUM * ENET_ALIGN(ENET_TXBUFF_SIZE) + ENET_BUFF_ALIGNMENT];
+    ethernetif_rx_stats_t rxStats;
+    uint16_t macOverrunLast;        /* Last reading of the 16-bit IEEE_R_MACERR counter */
+    uint8_t mcastHashRef[64];       /* Groups using each bit of the GAUR/GALR hash filter */
 };
 
 /*******************************************************************************
@@ -96,8 +124,21 @@ void ethernet_callback(ENET_Type *base, enet_handle_t *handle, enet_event_t even
     switch (event)
     {
         case kENET_RxEvent:
-            ethernetif_input(netif);
-            break;
+        {
+            /* Only wake the RX task here, frames are read out in task context. */
+            portBASE_TYPE taskToWake = pdFALSE;
+
+            if (__get_IPSR())
+            {
+                vTaskNotifyGiveFromISR(ethernetif->rxTask, &taskToWake);
+                portYIELD_FROM_ISR(taskToWake);
+            }
+            else
+            {
+                xTaskNotifyGive(ethernetif->rxTask);
+            }
+        }
+        break;
         case kENET_TxEvent:
         {
             portBASE_TYPE taskToWake = pdFALSE;
@@ -120,6 +161,87 @@ void ethernet_callback(ENET_Type *base, enet_handle_t *handle, enet_event_t even
             break;
     }
 }
+
+/**
+ * Network RX task. Woken by ethernet_callback() on kENET_RxEvent, it drains
+ * every ready receive descriptor in one batch and hands the frames to lwIP.
+ *
+ * @param arg the lwip network interface structure for this ethernetif
+ */
+static void ethernetif_rx_task(void *arg)
+{
+    struct netif *netif = (struct netif *)arg;
+
+    while (1)
+    {
+        /* Several RX events may collapse into one wake-up, the drain picks them all up. */
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        ethernetif_input(netif);
+    }
+}
+#endif
+
+#if (LWIP_IPV4 && LWIP_IGMP) || (LWIP_IPV6 && LWIP_IPV6_MLD)
+/**
+ * Hash filter bit of a multicast MAC address, the CRC-32 based index that
+ * ENET_AddMulticastGroup() uses to pick a GAUR/GALR bit.
+ */
+static uint8_t ethernetif_mcast_hash(const uint8_t *address)
+{
+  uint32_t crc = 0xFFFFFFFFU;
+
+  for (uint32_t i = 0; i < ETHARP_HWADDR_LEN; i++)
+  {
+    uint8_t c = address[i];
+
+    for (uint32_t bit = 0; bit < 8U; bit++)
+    {
+      if ((c ^ crc) & 1U)
+      {
+        crc = (crc >> 1U) ^ 0xEDB88320U;
+      }
+      else
+      {
+        crc >>= 1U;
+      }
+      c >>= 1U;
+    }
+  }
+
+  return (uint8_t)(crc >> 26U);
+}
+
+/**
+ * Updates the hash filter for a group join or leave. Several groups can
+ * share a hash bit, so a bit is only cleared when its last group leaves.
+ */
+static err_t ethernetif_mcast_filter(struct ethernetif *ethernetif, uint8_t *multicastMacAddr, bool add)
+{
+  uint8_t *ref = &ethernetif->mcastHashRef[ethernetif_mcast_hash(multicastMacAddr)];
+
+  if (add)
+  {
+    if (*ref == 0xFFU)
+    {
+      return ERR_MEM;
+    }
+    if ((*ref)++ == 0U)
+    {
+      /* Adds the ENET device to a multicast group.*/
+      ENET_AddMulticastGroup(ethernetif->base, multicastMacAddr);
+    }
+  }
+  else if (*ref != 0U)
+  {
+    if (--(*ref) == 0U)
+    {
+      /* Moves the ENET device from a multicast group.*/
+      ENET_LeaveMulticastGroup(ethernetif->base, multicastMacAddr);
+    }
+  }
+
+  return ERR_OK;
+}
 #endif
 
 #if LWIP_IPV4 && LWIP_IGMP
@@ -137,16 +259,10 @@ static err_t ethernetif_igmp_mac_filter(struct netif *netif, const ip4_addr_t *g
 
   switch (action) {
     case IGMP_ADD_MAC_FILTER: 
-      /* Adds the ENET device to a multicast group.*/
-      ENET_AddMulticastGroup(ethernetif->base, multicastMacAddr);
-      result = ERR_OK;
+      result = ethernetif_mcast_filter(ethernetif, multicastMacAddr, true);
       break;
     case IGMP_DEL_MAC_FILTER:
-      /* Moves the ENET device from a multicast group.*/
-    #if 0
-      ENET_LeaveMulticastGroup(ethernetif->base, multicastMacAddr);
-    #endif
-      result = ERR_OK;
+      result = ethernetif_mcast_filter(ethernetif, multicastMacAddr, false);
       break;
     default:
       result = ERR_IF;
@@ -172,16 +288,10 @@ static err_t ethernetif_mld_mac_filter(struct netif *netif, const ip6_addr_t *gr
 
   switch (action) {
     case MLD6_ADD_MAC_FILTER: 
-      /* Adds the ENET device to a multicast group.*/
-      ENET_AddMulticastGroup(ethernetif->base, multicastMacAddr);
-      result = ERR_OK;
+      result = ethernetif_mcast_filter(ethernetif, multicastMacAddr, true);
       break;
     case MLD6_DEL_MAC_FILTER:
-      /* Moves the ENET device from a multicast group.*/
-    #if 0
-      ENET_LeaveMulticastGroup(ethernetif->base, multicastMacAddr);
-    #endif
-      result = ERR_OK;
+      result = ethernetif_mcast_filter(ethernetif, multicastMacAddr, false);
       break;
     default:
       result = ERR_IF;
@@ -192,6 +302,77 @@ static err_t ethernetif_mld_mac_filter(struct netif *netif, const ip6_addr_t *gr
 }
 #endif
 
+#if ENET_RX_ZERO_COPY
+/**
+ * Called by lwIP when the last reference to a zero-copy RX pbuf is dropped.
+ * The DMA buffer goes back on the spare list, ready to re-arm a descriptor.
+ */
+static void ethernetif_rx_pbuf_free(struct pbuf *p)
+{
+    struct rx_pbuf_wrapper *wrapper = (struct rx_pbuf_wrapper *)p;
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    wrapper->next = ethernetif_0.rxSpare;
+    ethernetif_0.rxSpare = wrapper;
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+/**
+ * Takes the single-descriptor frame at the current RX descriptor without
+ * copying it: the DMA buffer is wrapped in a custom pbuf and the descriptor
+ * is re-armed with a spare buffer.
+ *
+ * @return the pbuf, or NULL if no spare buffer is available (caller copies)
+ */
+static struct pbuf *ethernetif_rx_take(struct ethernetif *ethernetif, uint32_t len)
+{
+    volatile enet_rx_bd_struct_t *bd = ethernetif->handle.rxBdCurrent;
+    struct rx_pbuf_wrapper *wrapper;
+    struct rx_pbuf_wrapper *spare;
+    uint8_t *rxBuffer = (uint8_t *)ENET_ALIGN(ethernetif->RxDataBuff);
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    if (!(bd->control & ENET_BUFFDESCRIPTOR_RX_LAST_MASK))
+    {
+        return NULL;
+    }
+
+    SYS_ARCH_PROTECT(lev);
+    spare = ethernetif->rxSpare;
+    if (spare != NULL)
+    {
+        ethernetif->rxSpare = spare->next;
+    }
+    SYS_ARCH_UNPROTECT(lev);
+
+    if (spare == NULL)
+    {
+        return NULL;
+    }
+
+    wrapper = &ethernetif->RxPbufs[(bd->buffer - rxBuffer) / ethernetif->handle.rxBuffSizeAlign];
+    wrapper->p.custom_free_function = ethernetif_rx_pbuf_free;
+
+    /* Re-arm the descriptor with the spare buffer, as ENET_ReadFrame() would after a copy. */
+    bd->buffer = spare->buffer;
+    bd->control &= ENET_BUFFDESCRIPTOR_RX_WRAP_MASK;
+    bd->control |= ENET_BUFFDESCRIPTOR_RX_EMPTY_MASK;
+    if (bd->control & ENET_BUFFDESCRIPTOR_RX_WRAP_MASK)
+    {
+        ethernetif->handle.rxBdCurrent = ethernetif->handle.rxBdBase;
+    }
+    else
+    {
+        ethernetif->handle.rxBdCurrent++;
+    }
+    ethernetif->base->RDAR = ENET_RDAR_RDAR_MASK;
+
+    return pbuf_alloced_custom(PBUF_RAW, len, PBUF_REF, &wrapper->p, wrapper->buffer,
+                               ethernetif->handle.rxBuffSizeAlign);
+}
+#endif
+
 /**
  * In this function, the hardware should be initialized.
  * Called from ethernetif_init().
@@ -275,6 +456,13 @@ low_level_init(struct netif *netif)
     ethernetif->enetTransmitAccessEvent = xEventGroupCreate();
     ethernetif->txFlag = 0x1;
 
+    /* Create the task that receives frames on behalf of the ENET interrupt. */
+    if (xTaskCreate(ethernetif_rx_task, "enet_rx", ENET_RX_TASK_STACKSIZE, netif, ENET_RX_TASK_PRIORITY,
+                    &ethernetif->rxTask) != pdPASS)
+    {
+        LWIP_ASSERT("ethernetif: RX task creation failed", 0);
+    }
+
     config.interrupt |= kENET_RxFrameInterrupt | kENET_TxFrameInterrupt | kENET_TxBufferInterrupt;
 
     NVIC_SetPriority(ENET_Receive_IRQn, ENET_PRIORITY);
@@ -290,6 +478,25 @@ low_level_init(struct netif *netif)
 #if USE_RTOS && defined(FSL_RTOS_FREE_RTOS)
     ENET_SetCallback(&ethernetif->handle, ethernet_callback, netif);
 #endif
+
+#if ENET_RX_ZERO_COPY
+    /* Every DMA buffer gets a pbuf wrapper; those past the ring become spares. */
+    ethernetif->rxSpare = NULL;
+    for (uint32_t i = 0; i < ENET_RXBUFF_NUM; i++)
+    {
+        ethernetif->RxPbufs[i].buffer = buffCfg.rxBufferAlign + i * buffCfg.rxBuffSizeAlign;
+        if (i >= ENET_RXBD_NUM)
+        {
+            ethernetif->RxPbufs[i].next = ethernetif->rxSpare;
+            ethernetif->rxSpare = &ethernetif->RxPbufs[i];
+        }
+    }
+#endif
+    /* Enable the MIB counters, IEEE_R_MACERR reports FIFO overruns. */
+    ethernetif->base->MIBC = ENET_MIBC_MIB_CLEAR_MASK;
+    ethernetif->base->MIBC = 0;
+    ethernetif->macOverrunLast = 0;
+
     ENET_ActiveRead(ethernetif->base);
   }	
 #if LWIP_IPV6 && LWIP_IPV6_MLD
@@ -451,6 +658,22 @@ low_level_input(struct netif *netif)
       len += ETH_PAD_SIZE; /* allow room for Ethernet padding */
     #endif
 
+    #if ENET_RX_ZERO_COPY
+      /* Lend the DMA buffer to lwIP; fall back to a copy when no spare is left. */
+      p = ethernetif_rx_take(ethernetif, len);
+      if (p != NULL) {
+        MIB2_STATS_NETIF_ADD(netif, ifinoctets, p->tot_len);
+        if (((u8_t*)p->payload)[0] & 1) {
+          MIB2_STATS_NETIF_INC(netif, ifinnucastpkts);
+        } else {
+          MIB2_STATS_NETIF_INC(netif, ifinucastpkts);
+        }
+        LINK_STATS_INC(link.recv);
+        ethernetif->rxStats.zero_copy++;
+        return p;
+      }
+    #endif
+
       /* We allocate a pbuf chain of pbufs from the pool. */
       p = pbuf_alloc(PBUF_RAW, len, PBUF_POOL);
 
@@ -480,6 +703,7 @@ low_level_input(struct netif *netif)
         /* drop packet*/
         ENET_ReadFrame(ethernetif->base, &ethernetif->handle, NULL, 0);
         LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: Fail to allocate new memory space\n"));
+        ethernetif->rxStats.pool_empty++;
 
         LINK_STATS_INC(link.memerr);
         LINK_STATS_INC(link.drop);
@@ -500,6 +724,7 @@ low_level_input(struct netif *netif)
         /* Update the receive buffer. */
         ENET_ReadFrame(ethernetif->base, &ethernetif->handle, NULL, 0);
         LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: RxFrameError\n"));
+        ethernetif->rxStats.frame_errors++;
 
         LINK_STATS_INC(link.drop);
         MIB2_STATS_NETIF_INC(netif, ifindiscards);
@@ -510,6 +735,27 @@ low_level_input(struct netif *netif)
   return p;
 }
 
+/**
+ * Checks whether the DMA has filled every receive descriptor, i.e. none is
+ * left EMPTY for the MAC to write the next frame into.
+ *
+ * @return 1 if the ring is full
+ */
+static int ethernetif_rx_ring_full(struct ethernetif *ethernetif)
+{
+  volatile enet_rx_bd_struct_t *bd = ethernetif->handle.rxBdBase;
+  uint32_t i;
+
+  for (i = 0; i < ENET_RXBD_NUM; i++)
+  {
+    if (bd[i].control & ENET_BUFFDESCRIPTOR_RX_EMPTY_MASK)
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
 /**
  * This function should be called when a packet is ready to be read
  * from the interface. It uses the function low_level_input() that
@@ -522,9 +768,18 @@ low_level_input(struct netif *netif)
 void
 ethernetif_input(struct netif *netif)
 {
+  struct ethernetif *ethernetif;
   struct pbuf *p;
 
   LWIP_ASSERT("netif != NULL", (netif != NULL));
+  ethernetif = netif->state;
+
+  /* Every descriptor already handed back by the DMA means the ring filled
+   * before we got to it, and the MAC had nowhere to put the next frame. */
+  if (ethernetif_rx_ring_full(ethernetif))
+  {
+    ethernetif->rxStats.ring_full++;
+  }
 
   /* move received packet into a new pbuf */
   while((p = low_level_input(netif)) != NULL)
@@ -532,12 +787,31 @@ ethernetif_input(struct netif *netif)
     /* pass all packets to ethernet_input, which decides what packets it supports */
     if (netif->input(p, netif) != ERR_OK) { 
       LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: IP input error\n"));
+      ethernetif->rxStats.input_errors++;
       pbuf_free(p);
       p = NULL;
+    } else {
+      ethernetif->rxStats.frames++;
     }
   }
 }
 
+void
+ethernetif_get_rx_stats(struct netif *netif, ethernetif_rx_stats_t *stats)
+{
+  struct ethernetif *ethernetif = netif->state;
+  uint16_t overrun;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  SYS_ARCH_PROTECT(lev);
+  /* Fold the wrapping hardware counter into the 32-bit total. */
+  overrun = ethernetif->base->IEEE_R_MACERR & ENET_IEEE_R_MACERR_COUNT_MASK;
+  ethernetif->rxStats.mac_overrun += (uint16_t)(overrun - ethernetif->macOverrunLast);
+  ethernetif->macOverrunLast = overrun;
+  *stats = ethernetif->rxStats;
+  SYS_ARCH_UNPROTECT(lev);
+}
+
 /**
  * Should be called at the beginning of the program to set up the
  * network interface. It calls the function low_level_init() to do the
@@ -39,8 +39,23 @@
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
+/* Receive sizing guide.
+ *
+ * ENET_RX_MAX_BURST is the longest run of back-to-back frames the receive
+ * path must absorb without loss. For sACN that is the number of universes a
+ * console sends per refresh: at 100 Mbit/s a full universe arrives every
+ * ~55 us, so a whole burst can land before the RX task gets to run.
+ *
+ *   ENET_RXBD_NUM   >= ENET_RX_MAX_BURST    frames the ring holds untouched
+ *   ENET_RXBUFF_NUM  = ring + spares        spares bound frames queued in lwIP
+ *                                           (DEFAULT_UDP_RECVMBOX_SIZE, TCPIP_MBOX_SIZE)
+ *   PBUF_POOL_SIZE  >= ENET_RX_MAX_BURST    only used once the spares run out
+ *
+ * Each receive buffer costs ENET_RXBUFF_SIZE (1520) bytes of RAM.
+ * ENET_RX_MAX_BURST itself is set in lwipopts.h, next to the pbuf pool.
+ * Overflows show up in ethernetif_get_rx_stats(). */
 #ifndef ENET_RXBD_NUM
-    #define ENET_RXBD_NUM (5)
+    #define ENET_RXBD_NUM (ENET_RX_MAX_BURST)
 #endif
 #ifndef ENET_TXBD_NUM
     #define ENET_TXBD_NUM (3)
@@ -52,6 +67,17 @@
     #define ENET_TXBUFF_SIZE (ENET_FRAME_MAX_FRAMELEN)
 #endif
 
+/* Zero-copy receive: DMA buffers are handed to lwIP as custom pbufs and the
+ * descriptor is re-armed with a spare. Needs LWIP_SUPPORT_CUSTOM_PBUF. */
+#ifndef ENET_RX_ZERO_COPY
+    #define ENET_RX_ZERO_COPY (1)
+#endif
+/* Total receive DMA buffers, ring plus spares. Spares bound how many frames
+ * lwIP can hold before the driver falls back to copying into PBUF_POOL. */
+#ifndef ENET_RXBUFF_NUM
+    #define ENET_RXBUFF_NUM (ENET_RXBD_NUM * 2)
+#endif
+
 /* MAC address configuration. */
 #ifndef configMAC_ADDR0
 #define configMAC_ADDR0 0x00
@@ -83,6 +109,14 @@
 #ifndef ENET_1588_PRIORITY
     #define ENET_1588_PRIORITY  (5U)
 #endif
+/* Network RX task, runs the receive path deferred from the ENET interrupt.
+ * Keep it above TCPIP_THREAD_PRIO so a burst is drained before lwIP processes it. */
+#ifndef ENET_RX_TASK_PRIORITY
+    #define ENET_RX_TASK_PRIORITY   (9U)
+#endif
+#ifndef ENET_RX_TASK_STACKSIZE
+    #define ENET_RX_TASK_STACKSIZE  (512U)
+#endif
 /* The PHY address.*/
 #ifndef ENET_PHY_ADDRESS
     #define ENET_PHY_ADDRESS    (0)     
@@ -94,6 +128,18 @@
     #define ENET_ATONEGOTIATION_TIMEOUT     (0xFFFU)
 #endif
 
+/* Receive drop accounting, see ethernetif_get_rx_stats(). */
+typedef struct _ethernetif_rx_stats
+{
+    uint32_t frames;        /* Frames passed to lwIP */
+    uint32_t zero_copy;     /* Of those, handed over without a copy */
+    uint32_t ring_full;     /* Wakes that found no EMPTY descriptor left, the MAC may have dropped */
+    uint32_t pool_empty;    /* Frames dropped because PBUF_POOL was exhausted */
+    uint32_t input_errors;  /* Frames dropped because netif->input refused them (tcpip mbox full) */
+    uint32_t frame_errors;  /* Frames dropped for CRC, length or truncation errors */
+    uint32_t mac_overrun;   /* Frames lost to receive FIFO overflow in the MAC */
+} ethernetif_rx_stats_t;
+
 /**
  * This function should be passed as a parameter to netif_add()
  */
@@ -101,11 +147,20 @@ err_t ethernetif_init(struct netif *netif);
 
 /**
  * This function should be called when a packet is ready to be read
- * from the interface. 
- * It is used by bare-metal applications.
+ * from the interface. It reads every frame that is ready.
+ * It is used by bare-metal applications and by the RTOS RX task.
  *
  * @param netif the lwip network interface structure for this ethernetif
  */
 void ethernetif_input( struct netif *netif);
 
+/**
+ * Copies the receive drop counters of this ethernetif.
+ * Safe to call from any task.
+ *
+ * @param netif the lwip network interface structure for this ethernetif
+ * @param stats receives the counters
+ */
+void ethernetif_get_rx_stats(struct netif *netif, ethernetif_rx_stats_t *stats);
+
 #endif
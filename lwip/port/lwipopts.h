@@ -128,12 +128,26 @@
 #ifndef MEMP_NUM_SYS_TIMEOUT
 #define MEMP_NUM_SYS_TIMEOUT    10
 #endif
+/* MEMP_NUM_IGMP_GROUP: the number of multicast groups joined at once.
+   One per E1.31 universe (E131_MAX_UNIVERSES in E131_config.h, which
+   holds only defines), the sync universe and the all-systems group. */
+#ifndef MEMP_NUM_IGMP_GROUP
+#include "E131_config.h"
+#define MEMP_NUM_IGMP_GROUP     (E131_MAX_UNIVERSES + 2)
+#endif
 
 
 /* ---------- Pbuf options ---------- */
+/* ENET_RX_MAX_BURST: back-to-back frames to absorb without loss, i.e. the
+   number of universes sent per refresh. Sizes the ENET receive ring and the
+   pbuf pool, see the sizing guide in ethernetif.h. */
+#ifndef ENET_RX_MAX_BURST
+#define ENET_RX_MAX_BURST       8
+#endif
+
 /* PBUF_POOL_SIZE: the number of buffers in the pbuf pool. */
 #ifndef PBUF_POOL_SIZE
-#define PBUF_POOL_SIZE          9 //5
+#define PBUF_POOL_SIZE          (ENET_RX_MAX_BURST + 4)
 #endif
 
 /* PBUF_POOL_BUFSIZE: the size of each pbuf in the pbuf pool. */
@@ -141,6 +155,12 @@
 #define PBUF_POOL_BUFSIZE       1600
 #endif
 
+/* LWIP_SUPPORT_CUSTOM_PBUF: lets ethernetif hand ENET receive buffers
+   to the stack without copying them (ENET_RX_ZERO_COPY). */
+#ifndef LWIP_SUPPORT_CUSTOM_PBUF
+#define LWIP_SUPPORT_CUSTOM_PBUF 1
+#endif
+
 
 /* ---------- TCP options ---------- */
 #ifndef LWIP_TCP
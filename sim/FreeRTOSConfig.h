@@ -0,0 +1,65 @@
+/*
+ * FreeRTOSConfig.h
+ *
+ *  Kernel configuration of the Linux build (sim/), on the POSIX port of
+ *  the in-tree kernel (freertos/Source/portable/GCC/Posix).  Priorities and the API set follow sources/FreeRTOSConfig.h so the
+ *  firmware schedules the same way; tasks are threads and the heap is
+ *  malloc (heap_3), so stack sizes only need to satisfy pthreads.
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#include <assert.h>
+
+#define configUSE_PREEMPTION 1
+#define configUSE_IDLE_HOOK 1                    /* Sleeps until the next tick, see board_sim.c */
+#define configUSE_TICK_HOOK 0
+#define configCPU_CLOCK_HZ (96000000UL)
+#define configTICK_RATE_HZ ((TickType_t)1000)
+#define configMAX_PRIORITIES (18)
+#define configMINIMAL_STACK_SIZE ((unsigned short)4096)
+#define configTOTAL_HEAP_SIZE ((size_t)(1024 * 1024)) /* not used by heap_3 allocator */
+#define configMAX_TASK_NAME_LEN (10)
+#define configUSE_TRACE_FACILITY 1
+#define configUSE_16_BIT_TICKS 0
+#define configIDLE_SHOULD_YIELD 1
+#define configUSE_MUTEXES 1
+#define configQUEUE_REGISTRY_SIZE 8
+#define configCHECK_FOR_STACK_OVERFLOW 0
+#define configUSE_RECURSIVE_MUTEXES 1
+#define configUSE_MALLOC_FAILED_HOOK 0
+#define configUSE_APPLICATION_TASK_TAG 0
+#define configUSE_COUNTING_SEMAPHORES 1
+#define configUSE_TIME_SLICING 0
+
+/* Co-routine definitions. */
+#define configUSE_CO_ROUTINES 0
+#define configMAX_CO_ROUTINE_PRIORITIES (2)
+
+/* Software timer definitions. */
+#define configUSE_TIMERS 1
+#define configTIMER_TASK_PRIORITY (17)
+#define configTIMER_QUEUE_LENGTH 10
+#define configTIMER_TASK_STACK_DEPTH (configMINIMAL_STACK_SIZE * 2)
+
+#define INCLUDE_vTaskPrioritySet 1
+#define INCLUDE_uxTaskPriorityGet 1
+#define INCLUDE_vTaskDelete 1
+#define INCLUDE_vTaskCleanUpResources 1
+#define INCLUDE_vTaskSuspend 1
+#define INCLUDE_vTaskDelayUntil 1
+#define INCLUDE_vTaskDelay 1
+#define INCLUDE_xTaskGetSchedulerState 1
+#define INCLUDE_xTaskGetCurrentTaskHandle 1
+
+#define INCLUDE_xEventGroupSetBitFromISR 1
+#define INCLUDE_xTimerPendFunctionCall 1
+
+#define configUSE_STATS_FORMATTING_FUNCTIONS 1
+#define configGENERATE_RUN_TIME_STATS 0
+
+/* A failed assertion stops the process rather than spinning forever */
+#define configASSERT(x) assert(x)
+
+#endif /* FREERTOS_CONFIG_H */
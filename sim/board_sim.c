@@ -0,0 +1,53 @@
+/*
+ * board_sim.c
+ *
+ *  Board bring-up of the Linux build (sim/): there are no pins or clocks to
+ *  set up, and the debug console is stdout.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "board.h"
+#include "pin_mux.h"
+#include "clock_config.h"
+#include "fsl_device_registers.h"
+
+MPU_Type SIM_MPU;
+
+void BOARD_InitPins(void)
+{
+}
+
+void BOARD_BootClockRUN(void)
+{
+}
+
+void BOARD_InitDebugConsole(void)
+{
+    /* PRINTF output shows up as it is written, as on the UART */
+    setvbuf(stdout, NULL, _IONBF, 0);
+}
+
+int SIM_Printf(const char *format, ...)
+{
+    va_list ap;
+    int n;
+
+    va_start(ap, format);
+    portENTER_CRITICAL();
+    n = vprintf(format, ap);
+    portEXIT_CRITICAL();
+    va_end(ap);
+    return n;
+}
+
+/* Nothing to do until the tick, give the host its CPU back */
+void vApplicationIdleHook(void)
+{
+    pause();
+}
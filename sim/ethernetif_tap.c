@@ -0,0 +1,202 @@
+/*
+ * ethernetif_tap.c
+ *
+ *  The ethernetif.h interface over a Linux TAP device, so the firmware's
+ *  lwIP sees real Ethernet frames in sim/.  The interface is named by
+ *  SIM_TAP (default tap0) and has to exist and be up, owned by the user
+ *  running the simulator:
+ *
+ *      ip tuntap add dev tap0 mode tap user $USER
+ *      ip addr add 192.168.1.1/24 dev tap0
+ *      ip link set tap0 up
+ *
+ *  The receive task polls the device rather than blocking in read(), a
+ *  task blocked in a system call would hold up the POSIX port's scheduler.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/if.h>
+#include <linux/if_tun.h>
+
+#include "lwip/opt.h"
+#include "lwip/def.h"
+#include "lwip/pbuf.h"
+#include "lwip/sys.h"
+#include "lwip/etharp.h"
+#include "netif/ethernet.h"
+
+#include "ethernetif.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define IFNAME0 't'
+#define IFNAME1 'p'
+
+/* Receive poll period in ticks when the device is empty */
+#ifndef SIM_TAP_POLL
+#define SIM_TAP_POLL 1
+#endif
+
+struct ethernetif
+{
+    int fd;
+    ethernetif_rx_stats_t rxStats;
+};
+
+static struct ethernetif ethernetif_0;
+
+static err_t low_level_output(struct netif *netif, struct pbuf *p)
+{
+    struct ethernetif *ethernetif = netif->state;
+    uint8_t frame[ENET_FRAME_MAX_FRAMELEN];
+    u16_t len;
+
+    len = pbuf_copy_partial(p, frame, sizeof(frame), 0);
+    if (len != p->tot_len)
+        return ERR_BUF;
+
+    if (write(ethernetif->fd, frame, len) != len)
+        return ERR_IF;
+
+    return ERR_OK;
+}
+
+static struct pbuf *low_level_input(struct netif *netif)
+{
+    struct ethernetif *ethernetif = netif->state;
+    uint8_t frame[ENET_FRAME_MAX_FRAMELEN];
+    struct pbuf *p;
+    ssize_t len;
+
+    len = read(ethernetif->fd, frame, sizeof(frame));
+    if (len <= 0)
+        return NULL;
+
+    if (len < SIZEOF_ETH_HDR) {
+        ethernetif->rxStats.frame_errors++;
+        return NULL;
+    }
+
+    p = pbuf_alloc(PBUF_RAW, (u16_t)len, PBUF_POOL);
+    if (!p) {
+        ethernetif->rxStats.pool_empty++;
+        return NULL;
+    }
+
+    pbuf_take(p, frame, (u16_t)len);
+    return p;
+}
+
+static void ethernetif_rx_task(void *arg)
+{
+    struct netif *netif = (struct netif *)arg;
+
+    while (1)
+    {
+        ethernetif_input(netif);
+        vTaskDelay(SIM_TAP_POLL);
+    }
+}
+
+void ethernetif_input(struct netif *netif)
+{
+    struct ethernetif *ethernetif;
+    struct pbuf *p;
+
+    LWIP_ASSERT("netif != NULL", (netif != NULL));
+    ethernetif = netif->state;
+
+    while ((p = low_level_input(netif)) != NULL)
+    {
+        if (netif->input(p, netif) != ERR_OK) {
+            ethernetif->rxStats.input_errors++;
+            pbuf_free(p);
+        } else {
+            ethernetif->rxStats.frames++;
+        }
+    }
+
+    /* The TAP queue is the kernel's, there is no ring to fill and ring_full stays 0 */
+}
+
+void ethernetif_get_rx_stats(struct netif *netif, ethernetif_rx_stats_t *stats)
+{
+    struct ethernetif *ethernetif = netif->state;
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    *stats = ethernetif->rxStats;
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+err_t ethernetif_init(struct netif *netif)
+{
+    struct ethernetif *ethernetif = &ethernetif_0;
+    const char *name = getenv("SIM_TAP");
+    struct ifreq ifr;
+
+    LWIP_ASSERT("netif != NULL", (netif != NULL));
+
+    ethernetif->fd = open("/dev/net/tun", O_RDWR | O_NONBLOCK);
+    if (ethernetif->fd < 0) {
+        perror("/dev/net/tun");
+        return ERR_IF;
+    }
+
+    memset(&ifr, 0, sizeof(ifr));
+    ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+    strncpy(ifr.ifr_name, name ? name : "tap0", IFNAMSIZ - 1);
+    if (ioctl(ethernetif->fd, TUNSETIFF, &ifr) < 0) {
+        fprintf(stderr, "%s: %s\n", ifr.ifr_name, strerror(errno));
+        close(ethernetif->fd);
+        return ERR_IF;
+    }
+
+#if LWIP_NETIF_HOSTNAME
+    netif->hostname = "lwip";
+#endif
+
+    netif->state = ethernetif;
+    netif->name[0] = IFNAME0;
+    netif->name[1] = IFNAME1;
+#if LWIP_IPV4
+    netif->output = etharp_output;
+#endif
+#if LWIP_IPV6
+    netif->output_ip6 = ethip6_output;
+#endif
+    netif->linkoutput = low_level_output;
+
+    netif->hwaddr_len = ETHARP_HWADDR_LEN;
+    netif->hwaddr[0] = configMAC_ADDR0;
+    netif->hwaddr[1] = configMAC_ADDR1;
+    netif->hwaddr[2] = configMAC_ADDR2;
+    netif->hwaddr[3] = configMAC_ADDR3;
+    netif->hwaddr[4] = configMAC_ADDR4;
+    netif->hwaddr[5] = configMAC_ADDR5;
+    netif->mtu = 1500;
+
+    /* The TAP device passes every frame, multicast needs no filter */
+    netif->flags |= NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_LINK_UP;
+#if LWIP_IPV4 && LWIP_IGMP
+    netif->flags |= NETIF_FLAG_IGMP;
+#endif
+#if LWIP_IPV6 && LWIP_IPV6_MLD
+    netif->flags |= NETIF_FLAG_MLD6;
+#endif
+
+    if (xTaskCreate(ethernetif_rx_task, "enet_rx", ENET_RX_TASK_STACKSIZE, netif, ENET_RX_TASK_PRIORITY,
+                    NULL) != pdPASS)
+    {
+        LWIP_ASSERT("ethernetif: RX task creation failed", 0);
+    }
+
+    return ERR_OK;
+}
@@ -0,0 +1,22 @@
+/*
+ * fsl_common.h
+ *
+ *  What the Linux build (sim/) takes from the KSDK common header and CMSIS.
+ */
+
+#ifndef _FSL_COMMON_H_
+#define _FSL_COMMON_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Tasks are threads and interrupt handlers do not exist, so code never runs
+ * in handler mode */
+static inline uint32_t __get_IPSR(void)
+{
+    return 0;
+}
+
+#endif /* _FSL_COMMON_H_ */
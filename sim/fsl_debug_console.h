@@ -0,0 +1,21 @@
+/*
+ * fsl_debug_console.h
+ *
+ *  The debug console of the Linux build (sim/) is stdout, written in a
+ *  critical section so the tick never preempts a task holding the stdio
+ *  lock.  As in the KSDK the header brings in fsl_common.h, which
+ *  sys_arch.c relies on.
+ */
+
+#ifndef _FSL_DEBUG_CONSOLE_H_
+#define _FSL_DEBUG_CONSOLE_H_
+
+#include <stdio.h>
+
+#include "fsl_common.h"
+
+int SIM_Printf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+#define PRINTF SIM_Printf
+
+#endif /* _FSL_DEBUG_CONSOLE_H_ */
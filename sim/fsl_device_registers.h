@@ -0,0 +1,22 @@
+/*
+ * fsl_device_registers.h
+ *
+ *  The registers main.c touches, backed by memory in sim/.
+ */
+
+#ifndef _FSL_DEVICE_REGISTERS_H_
+#define _FSL_DEVICE_REGISTERS_H_
+
+#include "fsl_common.h"
+
+typedef struct
+{
+    volatile uint32_t CESR;
+} MPU_Type;
+
+extern MPU_Type SIM_MPU;
+
+#define MPU (&SIM_MPU)
+#define MPU_CESR_VLD_MASK (0x1U)
+
+#endif /* _FSL_DEVICE_REGISTERS_H_ */
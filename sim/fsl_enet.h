@@ -0,0 +1,15 @@
+/*
+ * fsl_enet.h
+ *
+ *  The ENET sizes ethernetif.h is written against; sim/ receives and sends
+ *  frames through a TAP interface instead (ethernetif_tap.c).
+ */
+
+#ifndef _FSL_ENET_H_
+#define _FSL_ENET_H_
+
+#include "fsl_common.h"
+
+#define ENET_FRAME_MAX_FRAMELEN 1518U
+
+#endif /* _FSL_ENET_H_ */
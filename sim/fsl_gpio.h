@@ -0,0 +1,12 @@
+/*
+ * fsl_gpio.h
+ *
+ *  board.h names GPIO pins in macros only; nothing is driven in sim/.
+ */
+
+#ifndef _FSL_GPIO_H_
+#define _FSL_GPIO_H_
+
+#include "fsl_common.h"
+
+#endif /* _FSL_GPIO_H_ */
@@ -0,0 +1,12 @@
+/*
+ * fsl_pit.h
+ *
+ *  The PIT only clocks bare metal lwIP; the Linux build (sim/) runs FreeRTOS.
+ */
+
+#ifndef _FSL_PIT_H_
+#define _FSL_PIT_H_
+
+#include "fsl_common.h"
+
+#endif /* _FSL_PIT_H_ */
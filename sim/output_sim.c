@@ -0,0 +1,96 @@
+/*
+ * output_sim.c
+ *
+ *  Pixel drivers of the Linux build (sim/).  Every frame shown completes at
+ *  once and, when SIM_FRAMES names a file, is appended to it as a 32 bit
+ *  little endian byte count followed by the driver's frame: GRB bytes for
+ *  WS2812, every strand's GRB bytes in turn for WS2812PORT and the complete
+ *  SPI frame for APA102.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "ws2812.h"
+#include "apa102.h"
+
+static FILE *frames;
+
+static void SIM_Open(void)
+{
+    const char *path = getenv("SIM_FRAMES");
+
+    if (path && !frames) {
+        frames = fopen(path, "wb");
+        if (!frames)
+            perror(path);
+    }
+}
+
+static bool SIM_Record(const uint8_t *data, size_t stride, size_t bytes, size_t strands)
+{
+    size_t total = bytes * strands;
+    uint8_t len[4] = { total, total >> 8, total >> 16, total >> 24 };
+    size_t s;
+
+    /* stdio takes a lock, keep the tick out */
+    if (frames) {
+        portENTER_CRITICAL();
+        fwrite(len, 1, sizeof(len), frames);
+        for (s = 0; s < strands; s++)
+            fwrite(data + s * stride, 1, bytes, frames);
+        fflush(frames);
+        portEXIT_CRITICAL();
+    }
+    return true;
+}
+
+void WS2812_Init(ws2812_type_t type)
+{
+    (void)type;
+    SIM_Open();
+}
+
+bool WS2812_Show(const uint8_t *data, size_t bytes)
+{
+    return SIM_Record(data, bytes, bytes, 1);
+}
+
+bool WS2812_IsBusy(void)
+{
+    return false;
+}
+
+void WS2812PORT_Init(ws2812_type_t type)
+{
+    (void)type;
+    SIM_Open();
+}
+
+bool WS2812PORT_Show(const uint8_t *data, size_t stride, size_t bytes)
+{
+    return SIM_Record(data, stride, bytes, WS2812PORT_STRANDS);
+}
+
+bool WS2812PORT_IsBusy(void)
+{
+    return false;
+}
+
+void APA102_Init(void)
+{
+    SIM_Open();
+}
+
+bool APA102_Show(const uint8_t *frame, size_t bytes)
+{
+    return SIM_Record(frame, bytes, bytes, 1);
+}
+
+bool APA102_IsBusy(void)
+{
+    return false;
+}
@@ -19,177 +19,483 @@
 
 #include "E131.h"
 #include <string.h>
-#include "lwip\netif.h"
 
 
-/* E1.17 ACN Packet Identifier */
+uint8_t       *data;                /* Pointer to DMX channel data */
+uint16_t      universe;             /* DMX Universe of last valid packet */
+e131_stats_t  stats;                /* Statistics tracker */
+
+/* Universe table, indexed by universe - universe_first */
+static e131_universe_t universes[E131_MAX_UNIVERSES];
+static uint16_t        universe_first;
+static uint8_t         universe_count;
+
+static e131_callback_t callback;        /* New data notification */
+static e131_loss_callback_t loss_callback;  /* Lost universe notification */
 
 
 /* Constructor */
 void E131_init()
 {
 
-    memset(pbuff1.raw, 0, sizeof(pbuff1.raw));
-    memset(pbuff2.raw, 0, sizeof(pbuff2.raw));
-    packet = &pbuff1;
-    pwbuff = &pbuff2;
-
-    sequence = 0;
     stats.num_packets = 0;
     stats.sequence_errors = 0;
     stats.packet_errors = 0;
+    stats.start_codes = 0;
+    stats.source_drops = 0;
+    stats.discovery = 0;
+
+    E131_setUniverses(E131_DEFAULT_UNIVERSE, E131_DEFAULT_UNIVERSE_COUNT);
+
+}
+
+void E131_setUniverses(uint16_t universe, uint8_t n)
+{
+    if (n > E131_MAX_UNIVERSES)
+        n = E131_MAX_UNIVERSES;
+
+    for (uint8_t i = 0; i < n; i++) {
+        e131_universe_t *u = &universes[i];
+
+        memset(u, 0, sizeof(*u));
+        u->data = u->buff1;
+        u->wbuff = u->buff2;
+    }
+
+    universe_first = universe;
+    universe_count = n;
+}
+
+uint16_t E131_firstUniverse(void)
+{
+    return universe_first;
+}
 
+uint8_t E131_universeCount(void)
+{
+    return universe_count;
 }
 
-void initUnicast() {
-    //delay(100);
-	conn = netconn_new(NETCONN_UDP);
-	err = netconn_bind(conn, IP_ADDR_ANY, 5568);
+e131_universe_t *E131_getUniverse(uint16_t universe)
+{
+    /* Unsigned wrap makes universes below the range fail the bound check too */
+    uint16_t offset = universe - universe_first;
 
-	if(err != ERR_OK)
-	{
-		PRINTF("NETCONN BIND FAIL\r\n");
-		return;
-	}
+    if (offset >= universe_count)
+        return NULL;
+    return &universes[offset];
+}
 
-    PRINTF("- Unicast port: %d\r\n", E131_DEFAULT_PORT);
+void E131_setCallback(e131_callback_t cb)
+{
+    callback = cb;
+}
 
+void E131_setLossCallback(e131_loss_callback_t cb)
+{
+    loss_callback = cb;
 }
 
-void initMulticast(uint16_t universe, uint8_t n) {
-    //delay(100);
-	ip4_addr_t address;
-	IP4_ADDR(&address, 239, 255, ((universe >> 8) & 0xff), ((universe >> 0) & 0xff));
+void E131_poll(uint32_t now)
+{
+    for (uint8_t i = 0; i < universe_count; i++)
+    {
+        e131_universe_t *u = &universes[i];
+        uint32_t elapsed;
 
-	ip4_addr_t *ifaddr;
-	ip4_addr_t multicast_addr;
+        /* Universes never heard from have nothing to lose */
+        if (!u->lost)
+        {
+            if (!u->stats.num_packets || E131_liveSources(u, now))
+                continue;
+            u->lost = 1;
+            u->lost_at = now;
+            u->lost_polled = 0;
+        }
 
-    netconn_getaddr(conn, ifaddr, NULL, 1);	// Save Local IP of the Netconn "conn" to ifaddr
+        elapsed = now - u->lost_at;
+        if (loss_callback)
+            loss_callback(u, elapsed, elapsed - u->lost_polled);
+        u->lost_polled = elapsed;
+    }
+}
 
-    for (uint8_t i = 1; i < n; i++) {
-    	IP4_ADDR(&multicast_addr, 239, 255, (((universe + i) >> 8) & 0xff), (((universe + i) >> 0) & 0xff));
 
-        igmp_joingroup(ifaddr, &multicast_addr);
+uint16_t E131_parseSync(const e131_sync_packet_t *packet, uint16_t size)
+{
+    /* Senders list their universes every 10 s under the same root vector;
+     * counted apart so packet_errors keeps meaning malformed packets */
+    if (validateDiscovery(packet, size) == ERROR_NONE)
+    {
+        stats.discovery++;
+        return 0;
     }
 
-    //TODO udp.beginMulticast(WiFi.localIP(), address, E131_DEFAULT_PORT);
-
-
-    PRINTF("- Universe: ");
-    PRINTF("%s\r\n", universe);
-    PRINTF("- Multicast address: ");
-    PRINTF(" %u.%u.%u.%u\r\n", ((u8_t *)&address)[0], ((u8_t *)&address)[1],
-           ((u8_t *)&address)[2], ((u8_t *)&address)[3]);
-
-}
-
-void E131_begin(e131_listen_t type, uint16_t universe, uint8_t n) {
-    if (type == E131_UNICAST)
-        initUnicast();
-    if (type == E131_MULTICAST)
-        initMulticast(universe, n);
-}
-
-
-void dumpError(e131_error_t error) {
-    switch (error) {
-    	case ERROR_NONE:
-    		break;
-        case ERROR_ACN_ID:
-        	PRINTF("INVALID PACKET ID: ");
-            for (uint8_t i = 0; i < sizeof(ACN_ID); i++)
-            	PRINTF("%02X", pwbuff->acn_id[i]);
-            PRINTF("\r\n");
-            break;
-        case ERROR_PACKET_SIZE:
-        	PRINTF("INVALID PACKET SIZE: \r\n");
-            break;
-        case ERROR_VECTOR_ROOT:
-        	PRINTF("INVALID ROOT VECTOR: 0x \r\n");
-            //Serial.println(htonl(pwbuff->root_vector), HEX);
-            break;
-        case ERROR_VECTOR_FRAME:
-        	PRINTF("INVALID FRAME VECTOR: 0x");
-            //Serial.println(htonl(pwbuff->frame_vector), HEX);
-            break;
-        case ERROR_VECTOR_DMP:
-        	PRINTF("INVALID DMP VECTOR: 0x");
-        	PRINTF("%02X\r\n", pwbuff->dmp_vector);
+    if (validateSync(packet, size))
+    {
+        stats.packet_errors++;
+        return 0;
     }
+
+    E131_sync(packet);
+    return 0;
 }
 
-uint16_t E131_parsePacket()
+uint16_t E131_parseBuffer(const uint8_t *raw, uint16_t size)
 {
+    const e131_packet_t *packet = (const e131_packet_t *)raw;
+    e131_universe_t *u;
     e131_error_t error;
-    uint16_t retval = 0;
-    int size = 0;
+    uint16_t count;
 
-    err = netconn_recv(conn, &buf);
+    if (size >= E131_SYNC_SIZE && E131_NTOHL(packet->root_vector) == VECTOR_ROOT_EXTENDED)
+        return E131_parseSync((const e131_sync_packet_t *)raw, size);
 
+    error = validate(packet, size);
+    if (error)
+    {
+        stats.packet_errors++;
+        return 0;
+    }
+
+    u = E131_accept(packet);
+    if (!u)
+        return 0;
+
+    count = E131_NTOHS(packet->property_value_count);
+    memcpy(u->target, packet->property_values, count);
+
+    return E131_commit(u, count);
+}
+
+e131_universe_t *E131_accept(const e131_packet_t *packet)
+{
+    e131_universe_t *u;
+    e131_source_t *src;
+    uint8_t top;
 
-    if(netbuf_copy(buf, pwbuff->raw, sizeof(pwbuff->raw)) != buf->p->tot_len) {
-    	LWIP_DEBUGF(LWIP_DBG_ON, ("netbuf_copy failed\n"));
-    	PRINTF("Fail\r\n");
+    stats.num_packets++;
+
+    u = E131_getUniverse(E131_NTOHS(packet->universe));
+    if (!u)
+        return NULL;
+
+    src = E131_getSource(u, packet->cid);
+    if (!src)
+    {
+        /* Every slot is held by a live source, a new one has to wait */
+        u->stats.source_drops++;
+        stats.source_drops++;
+        return NULL;
+    }
+    if (src->active)
+    {
+        /* E1.31 6.7.2: discard anything 0..-19 behind the last accepted packet */
+        int8_t diff = (int8_t)(packet->sequence_number - src->sequence);
+        if (diff <= 0 && diff > -E131_SEQUENCE_WINDOW)
+        {
+            u->stats.sequence_errors++;
+            stats.sequence_errors++;
+            return NULL;
+        }
     }
     else
     {
-    	//pwbuff[buf->p->tot_len] = '\0';
-    	size = buf->p->tot_len;
-
-    	/* PRINTF("Size of Buffer: %d\r\n", buf->p->tot_len);
-    	       for(int i = 0; i < buf->p->tot_len; i++)
-    	        	PRINTF("%02X",buffer->raw[i]);
-    	PRINTF("\r\n");
-    	*/
+        /* A terminating source that isn't tracked has nothing to end */
+        if (packet->options & E131_OPT_TERMINATED)
+            return NULL;
+        memcpy(src->cid, packet->cid, sizeof(src->cid));
+        src->active = 1;
+    }
+
+    /* E1.31 6.2.6: the source is gone at once and its data is ignored */
+    if (packet->options & E131_OPT_TERMINATED)
+    {
+        src->active = 0;
+        return NULL;
     }
 
+    src->sequence = packet->sequence_number;
+    src->last_seen = E131_now();
+    src->priority = packet->priority > E131_PRIORITY_MAX ? E131_PRIORITY_MAX : packet->priority;
 
-    if (size)
+    /* Alternate start codes (0xDD per-address priority, text, ...) share the
+     * source's sequence and keep it alive, but are not levels */
+    if (packet->property_values[0] != 0)
     {
-    	//pwbuff->raw = buffer;
-    	error = validate();
-        if (!error)
-        {
-            e131_packet_t *swap = packet;
-            packet = pwbuff;
-            pwbuff = swap;
-
-            universe = htons(packet->universe);
-            data = packet->property_values + 1;
-            retval = htons(packet->property_value_count) - 1;
-            if (packet->sequence_number != sequence++)
-            {
-                stats.sequence_errors++;
-                sequence = packet->sequence_number + 1;
-            }
-            stats.num_packets++;
+        u->stats.start_codes++;
+        stats.start_codes++;
+        return NULL;
+    }
+    u->stats.num_packets++;
+
+    /* Only the highest priority among the live sources drives the output */
+    top = E131_arbitrate(u, src->last_seen);
+    if (src->priority < top)
+        return NULL;
+    u->priority = top;
+    u->lost = 0;
+    u->sync_address = E131_NTOHS(packet->sync_address);
+    u->force_sync = (packet->options & E131_OPT_FORCE_SYNC) != 0;
+
+#if E131_HTP_MERGE
+    u->pending = src;
+    u->target = src->data;
+#else
+    u->target = u->wbuff;
+#endif
+
+    return u;
+}
+
+uint8_t E131_arbitrate(e131_universe_t *u, uint32_t now)
+{
+    uint8_t top = 0;
+
+    for (uint8_t i = 0; i < E131_MAX_SOURCES; i++)
+    {
+        e131_source_t *src = &u->sources[i];
 
+        if (!src->active)
+            continue;
+        if (now - src->last_seen > E131_SOURCE_TIMEOUT)
+        {
+            src->active = 0;
+            continue;
         }
-        else
+        if (src->priority > top)
+            top = src->priority;
+    }
+
+    return top;
+}
+
+uint8_t E131_liveSources(e131_universe_t *u, uint32_t now)
+{
+    uint8_t live = 0;
+
+    E131_arbitrate(u, now);
+    for (uint8_t i = 0; i < E131_MAX_SOURCES; i++)
+        live += u->sources[i].active;
+
+    return live;
+}
+
+e131_source_t *E131_getSource(e131_universe_t *u, const uint8_t *cid)
+{
+    e131_source_t *slot = NULL;
+    uint32_t now = E131_now();
+
+    for (uint8_t i = 0; i < E131_MAX_SOURCES; i++)
+    {
+        e131_source_t *src = &u->sources[i];
+
+        if (src->active && !memcmp(src->cid, cid, sizeof(src->cid)))
+            return src;
+        if (!slot && (!src->active || now - src->last_seen > E131_SOURCE_TIMEOUT))
+            slot = src;
+    }
+
+    /* Unknown source takes a free or timed out slot, never a live one */
+    if (slot)
+        slot->active = 0;
+    return slot;
+}
+
+#if E131_HTP_MERGE
+/* Highest takes precedence across the live sources at the controlling priority */
+static uint16_t E131_merge(e131_universe_t *u)
+{
+    e131_source_t *pending = u->pending;
+    uint16_t length = pending->length;
+
+    memcpy(u->wbuff, pending->data, length);
+
+    /* Alternate start codes are not levels, pass them through as sent */
+    if (pending->data[0] != 0)
+        return length;
+
+    for (uint8_t i = 0; i < E131_MAX_SOURCES; i++)
+    {
+        e131_source_t *src = &u->sources[i];
+
+        if (src == pending || !src->active || src->priority != u->priority || src->data[0] != 0)
+            continue;
+
+        for (uint16_t j = 1; j < src->length; j++)
         {
-            //dumpError(error);
-            stats.packet_errors++;
+            if (j >= length)
+                u->wbuff[j] = src->data[j];
+            else if (src->data[j] > u->wbuff[j])
+                u->wbuff[j] = src->data[j];
         }
+        if (src->length > length)
+            length = src->length;
+    }
+
+    return length;
+}
+#endif
+
+/* Make wbuff the visible buffer and tell the application */
+static void E131_latch(e131_universe_t *u, uint16_t count)
+{
+    uint8_t *swap;
+
+    swap = u->data;
+    u->data = u->wbuff;
+    u->wbuff = swap;
+    u->length = count;
+
+    universe = E131_universeNumber(u);
+    data = u->data + 1;
+
+    if (callback)
+        callback(u);
+}
+
+void E131_publish(e131_universe_t *u, uint16_t count)
+{
+    u->staged = 0;
+    E131_latch(u, count);
+}
+
+uint16_t E131_commit(e131_universe_t *u, uint16_t count)
+{
+#if E131_HTP_MERGE
+    u->pending->length = count;
+    count = E131_merge(u);
+#endif
+
+    /* Once syncs for our address flow, hold the data until the next one.
+     * Without syncs for E131_SYNC_TIMEOUT, latch on arrival again. */
+    if (u->sync_address && u->sync_seen &&
+        (u->force_sync || E131_now() - u->sync_seen <= E131_SYNC_TIMEOUT))
+    {
+        u->staged = 1;
+        u->staged_length = count;
+        return 0;
+    }
+
+    u->staged = 0;
+    E131_latch(u, count);
+    return count - 1;
+}
+
+uint8_t E131_sync(const e131_sync_packet_t *packet)
+{
+    uint16_t address = E131_NTOHS(packet->sync_address);
+    uint32_t now = E131_now();
+    uint8_t latched = 0;
+
+    /* sync_seen doubles as "synced" flag, keep it non-zero */
+    if (!now)
+        now = 1;
+
+    for (uint8_t i = 0; i < universe_count; i++)
+    {
+        e131_universe_t *u = &universes[i];
 
-        PRINTF("PR: %d   PE: %d     SE: %d\r", stats.num_packets, stats.packet_errors, stats.sequence_errors);
+        if (u->sync_address != address)
+            continue;
 
+        u->sync_seen = now;
+        if (u->staged)
+        {
+            u->staged = 0;
+            E131_latch(u, u->staged_length);
+            latched++;
+        }
     }
 
-    netbuf_delete(buf);
+    return latched;
+}
+
+uint16_t E131_universeNumber(const e131_universe_t *u)
+{
+    return universe_first + (uint16_t)(u - universes);
+}
 
-    return retval;
+/* Flags must be 0x7 and the length must reach from the PDU at 'start' to the end of the datagram */
+static inline int E131_badPdu(uint16_t flength, uint16_t start, uint16_t size)
+{
+	flength = E131_NTOHS(flength);
+	return (flength & E131_PDU_FLAGS_MASK) != E131_PDU_FLAGS || (flength & E131_PDU_LENGTH_MASK) != size - start;
 }
 
-e131_error_t validate()
+e131_error_t validate(const e131_packet_t *packet, uint16_t size)
 {
-	if (memcmp(pwbuff->acn_id, ACN_ID, sizeof(pwbuff->acn_id)))
+	if (size < E131_DMP_DATA || size > sizeof(e131_packet_t))
+		return ERROR_PACKET_SIZE;
+	if (E131_NTOHS(packet->preamble_size) != E131_PREAMBLE_SIZE || packet->postamble_size != 0 ||
+	    memcmp(packet->acn_id, ACN_ID, sizeof(packet->acn_id)))
 		return ERROR_ACN_ID;
-	if (htonl(pwbuff->root_vector) != VECTOR_ROOT)
+	if (E131_badPdu(packet->root_flength, E131_ROOT_FLENGTH, size))
+		return ERROR_PACKET_SIZE;
+	if (E131_NTOHL(packet->root_vector) != VECTOR_ROOT)
 		return ERROR_VECTOR_ROOT;
-	if (htonl(pwbuff->frame_vector) != VECTOR_FRAME)
+	if (E131_badPdu(packet->frame_flength, E131_FRAME_FLENGTH, size))
+		return ERROR_PACKET_SIZE;
+	if (E131_NTOHL(packet->frame_vector) != VECTOR_FRAME)
 		return ERROR_VECTOR_FRAME;
-	if (pwbuff->dmp_vector != VECTOR_DMP)
+	if (E131_badPdu(packet->dmp_flength, E131_DMP_FLENGTH, size))
+		return ERROR_PACKET_SIZE;
+	if (packet->dmp_vector != VECTOR_DMP || packet->type != E131_DMP_ADDRESS_TYPE ||
+	    packet->first_address != 0 || E131_NTOHS(packet->address_increment) != 1)
 		return ERROR_VECTOR_DMP;
+
+	/* The property values are exactly what is left of the datagram, a start code and up to a universe */
+	if (packet->property_value_count == 0 || E131_DMP_DATA + E131_NTOHS(packet->property_value_count) != size)
+		return ERROR_PACKET_SIZE;
+	return ERROR_NONE;
+}
+
+e131_error_t validateSync(const e131_sync_packet_t *packet, uint16_t size)
+{
+	if (size != E131_SYNC_SIZE)
+		return ERROR_PACKET_SIZE;
+	if (E131_NTOHS(packet->preamble_size) != E131_PREAMBLE_SIZE || packet->postamble_size != 0 ||
+	    memcmp(packet->acn_id, ACN_ID, sizeof(packet->acn_id)))
+		return ERROR_ACN_ID;
+	if (E131_badPdu(packet->root_flength, E131_ROOT_FLENGTH, size))
+		return ERROR_PACKET_SIZE;
+	if (E131_NTOHL(packet->root_vector) != VECTOR_ROOT_EXTENDED)
+		return ERROR_VECTOR_ROOT;
+	if (E131_badPdu(packet->frame_flength, E131_FRAME_FLENGTH, size))
+		return ERROR_PACKET_SIZE;
+	if (E131_NTOHL(packet->frame_vector) != VECTOR_FRAME_SYNC)
+		return ERROR_VECTOR_FRAME;
+	if (packet->sync_address == 0)
+		return ERROR_SYNC;
 	return ERROR_NONE;
 }
 
+e131_error_t validateDiscovery(const e131_sync_packet_t *packet, uint16_t size)
+{
+	const uint8_t *raw = (const uint8_t *)packet;
+	uint16_t flength;
+	uint32_t vector;
+
+	if (size < E131_DISCOVERY_SIZE)
+		return ERROR_PACKET_SIZE;
+	if (E131_NTOHS(packet->preamble_size) != E131_PREAMBLE_SIZE || packet->postamble_size != 0 ||
+	    memcmp(packet->acn_id, ACN_ID, sizeof(packet->acn_id)))
+		return ERROR_ACN_ID;
+	if (E131_badPdu(packet->root_flength, E131_ROOT_FLENGTH, size))
+		return ERROR_PACKET_SIZE;
+	if (E131_NTOHL(packet->root_vector) != VECTOR_ROOT_EXTENDED)
+		return ERROR_VECTOR_ROOT;
+	if (E131_badPdu(packet->frame_flength, E131_FRAME_FLENGTH, size))
+		return ERROR_PACKET_SIZE;
+	if (E131_NTOHL(packet->frame_vector) != VECTOR_FRAME_DISCOVERY)
+		return ERROR_VECTOR_FRAME;
+
+	/* The discovery layer is past the end of the sync packet structure */
+	memcpy(&flength, raw + E131_DISCOVERY_FLENGTH, sizeof(flength));
+	if (E131_badPdu(flength, E131_DISCOVERY_FLENGTH, size))
+		return ERROR_PACKET_SIZE;
+	memcpy(&vector, raw + E131_DISCOVERY_VECTOR, sizeof(vector));
+	if (E131_NTOHL(vector) != VECTOR_DISCOVERY_LIST)
+		return ERROR_VECTOR_FRAME;
+	return ERROR_NONE;
+}
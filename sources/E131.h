@@ -20,21 +20,64 @@
 #ifndef E131_H_
 #define E131_H_
 
+/* Protocol core: validation, universe table, source arbitration and sync.
+ * No network stack or hardware dependencies, the lwIP listeners are in
+ * E131_lwip.h and the host build links the core on its own. */
 
+#include <stdint.h>
+#include <string.h>
 
-#include "board.h"
-
-#include <lwip/ip_addr.h>
-#include <lwip/igmp.h>
-#include "lwip/opt.h"
-#include "lwip/api.h"
-#include "lwip/sys.h"
+#include "E131_config.h"
 
 
 /* Defaults */
 #define E131_DEFAULT_PORT 5568
 #define WIFI_CONNECT_TIMEOUT 10000  /* 10 seconds */
 
+/* Universe table, E131_MAX_UNIVERSES is in E131_config.h */
+#ifndef E131_DEFAULT_UNIVERSE
+#define E131_DEFAULT_UNIVERSE 1         /* First universe of the default range */
+#endif
+#ifndef E131_DEFAULT_UNIVERSE_COUNT
+#define E131_DEFAULT_UNIVERSE_COUNT 8   /* Number of universes in the default range */
+#endif
+#define E131_UNIVERSE_SIZE 513          /* Start code + 512 slots */
+#ifndef E131_MAX_SOURCES
+#define E131_MAX_SOURCES 4              /* Sources tracked per universe */
+#endif
+#define E131_SEQUENCE_WINDOW 20         /* Packets up to this far behind the last one are stale */
+#ifndef E131_SOURCE_TIMEOUT
+#define E131_SOURCE_TIMEOUT 2500        /* ms without packets before a source is considered lost */
+#endif
+#ifndef E131_SYNC_TIMEOUT
+#define E131_SYNC_TIMEOUT 2500          /* ms without sync packets before universes latch on arrival again */
+#endif
+#ifndef E131_POLL_INTERVAL
+#define E131_POLL_INTERVAL 25           /* ms between checks for lost universes */
+#endif
+#define E131_PRIORITY_DEFAULT 100
+#define E131_PRIORITY_MAX 200
+
+/* Merge equal-priority sources highest-takes-precedence instead of latest-takes-precedence.
+ * Costs a universe buffer per source slot. */
+#ifndef E131_HTP_MERGE
+#define E131_HTP_MERGE 0
+#endif
+
+/* Receive through udp_recv() in the tcpip thread instead of a netconn */
+#ifndef E131_RAW_RECV
+#define E131_RAW_RECV 0
+#endif
+
+/* Wire fields are big endian */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define E131_NTOHS(x) ((uint16_t)(x))
+#define E131_NTOHL(x) ((uint32_t)(x))
+#else
+#define E131_NTOHS(x) __builtin_bswap16(x)
+#define E131_NTOHL(x) __builtin_bswap32(x)
+#endif
+
 /* E1.31 Packet Offsets */
 #define E131_ROOT_PREAMBLE_SIZE 0
 #define E131_ROOT_POSTAMBLE_SIZE 2
@@ -47,7 +90,7 @@
 #define E131_FRAME_VECTOR 40
 #define E131_FRAME_SOURCE 44
 #define E131_FRAME_PRIORITY 108
-#define E131_FRAME_RESERVED 109
+#define E131_FRAME_SYNCADDR 109
 #define E131_FRAME_SEQ 111
 #define E131_FRAME_OPT 112
 #define E131_FRAME_UNIVERSE 113
@@ -60,6 +103,32 @@
 #define E131_DMP_COUNT 123
 #define E131_DMP_DATA 125
 
+/* E1.31 Synchronization Packet Offsets */
+#define E131_SYNC_SEQ 44
+#define E131_SYNC_ADDR 45
+#define E131_SYNC_RESERVED 47
+#define E131_SYNC_SIZE 49
+
+/* E1.31 Universe Discovery Packet: root and framing layer, then the list */
+#define E131_DISCOVERY_FLENGTH 112
+#define E131_DISCOVERY_VECTOR 114
+#define E131_DISCOVERY_SIZE 120         /* With no universes listed */
+
+/* PDU flags and length words: the flags are always 0x7 and the length runs
+ * from the start of the PDU to the end of the datagram */
+#define E131_PDU_FLAGS 0x7000
+#define E131_PDU_FLAGS_MASK 0xf000
+#define E131_PDU_LENGTH_MASK 0x0fff
+#define E131_PREAMBLE_SIZE 0x0010
+
+/* DMP Set Property header of E1.31 data */
+#define E131_DMP_ADDRESS_TYPE 0xa1
+
+/* Frame Layer Options */
+#define E131_OPT_PREVIEW 0x80
+#define E131_OPT_TERMINATED 0x40
+#define E131_OPT_FORCE_SYNC 0x20
+
 /* E1.31 Packet Structure */
 typedef union {
     struct {
@@ -76,7 +145,7 @@ typedef union {
         uint32_t frame_vector;
         uint8_t  source_name[64];
         uint8_t  priority;
-        uint16_t reserved;
+        uint16_t sync_address;
         uint8_t  sequence_number;
         uint8_t  options;
         uint16_t universe;
@@ -94,13 +163,78 @@ typedef union {
     uint8_t raw[638];
 } e131_packet_t;
 
+/* E1.31 Synchronization Packet Structure */
+typedef struct {
+    /* Root Layer */
+    uint16_t preamble_size;
+    uint16_t postamble_size;
+    uint8_t  acn_id[12];
+    uint16_t root_flength;
+    uint32_t root_vector;
+    uint8_t  cid[16];
+
+    /* Frame Layer */
+    uint16_t frame_flength;
+    uint32_t frame_vector;
+    uint8_t  sequence_number;
+    uint16_t sync_address;
+    uint16_t reserved;
+} __attribute__((packed)) e131_sync_packet_t;
+
 /* Status structure */
 typedef struct {
     uint32_t    num_packets;
     uint32_t    sequence_errors;
     uint32_t    packet_errors;
+    uint32_t    start_codes;        /* Packets with a non-zero start code, not latched */
+    uint32_t    source_drops;       /* Packets from new sources while E131_MAX_SOURCES were live */
+    uint32_t    discovery;          /* Universe discovery packets, valid but of no use here */
 } e131_stats_t;
 
+/* Per-source state within a universe */
+typedef struct {
+    uint8_t       cid[16];                      /* Component identifier of the source */
+    uint8_t       sequence;                     /* Last accepted sequence number */
+    uint8_t       active;                       /* Slot in use */
+    uint8_t       priority;                     /* Priority of the last accepted packet */
+    uint32_t      last_seen;                    /* E131_now() of the last accepted packet */
+#if E131_HTP_MERGE
+    uint8_t       data[E131_UNIVERSE_SIZE];     /* Slot data of this source, start code first */
+    uint16_t      length;                       /* Number of slots in data */
+#endif
+} e131_source_t;
+
+/* Per-universe receive state */
+typedef struct {
+    uint8_t       buff1[E131_UNIVERSE_SIZE];    /* Slot buffer */
+    uint8_t       buff2[E131_UNIVERSE_SIZE];    /* Double buffer */
+    uint8_t       *data;                        /* Pointer to last valid slot data, start code first */
+    uint8_t       *wbuff;                       /* Pointer to working slot buffer */
+    uint16_t      length;                       /* Number of slots in data, start code included */
+    uint8_t       *target;                      /* Where the accepted packet's slots are to be copied */
+    uint8_t       priority;                     /* Priority of the sources in control */
+    uint8_t       staged;                       /* wbuff holds data waiting for a sync packet */
+    uint8_t       force_sync;                   /* Sender asked to hold data until synced, even after timeout */
+    uint16_t      sync_address;                 /* Synchronization universe, 0 if unsynchronized */
+    uint16_t      staged_length;                /* Number of slots in wbuff while staged */
+    uint32_t      sync_seen;                    /* E131_now() of the last sync packet for sync_address */
+    uint8_t       lost;                         /* Every source timed out or terminated */
+    uint32_t      lost_at;                      /* E131_now() when the universe was found lost */
+    uint32_t      lost_polled;                  /* ms since the loss at the last poll */
+    e131_source_t sources[E131_MAX_SOURCES];    /* Sequence tracking and arbitration per source */
+#if E131_HTP_MERGE
+    e131_source_t *pending;                     /* Source of the accepted packet */
+#endif
+    e131_stats_t  stats;                        /* Statistics tracker */
+} e131_universe_t;
+
+/* Called in the receiving context each time a universe gets new data */
+typedef void (*e131_callback_t)(e131_universe_t *u);
+
+/* Called from E131_poll() for each lost universe, with the ms since the
+ * loss and since the previous call */
+typedef void (*e131_loss_callback_t)(e131_universe_t *u, uint32_t elapsed, uint32_t step);
+
 /* Error Types */
 typedef enum {
     ERROR_NONE,
@@ -108,7 +242,8 @@ typedef enum {
     ERROR_PACKET_SIZE,
     ERROR_VECTOR_ROOT,
     ERROR_VECTOR_FRAME,
-    ERROR_VECTOR_DMP
+    ERROR_VECTOR_DMP,
+    ERROR_SYNC
 } e131_error_t;
 
 /* E1.31 Listener Types */
@@ -121,46 +256,80 @@ typedef enum {
 /* Constants for packet validation */
 static const uint8_t ACN_ID[12] = { 0x41, 0x53, 0x43, 0x2d, 0x45, 0x31, 0x2e, 0x31, 0x37, 0x00, 0x00, 0x00 };;
 static const uint32_t VECTOR_ROOT = 4;
+static const uint32_t VECTOR_ROOT_EXTENDED = 8;
 static const uint32_t VECTOR_FRAME = 2;
+static const uint32_t VECTOR_FRAME_SYNC = 1;
+static const uint32_t VECTOR_FRAME_DISCOVERY = 2;      /* Under VECTOR_ROOT_EXTENDED */
+static const uint32_t VECTOR_DISCOVERY_LIST = 1;
 static const uint8_t VECTOR_DMP = 2;
 
-e131_packet_t pbuff1;   /* Packet buffer */
-e131_packet_t pbuff2;   /* Double buffer */
+extern uint8_t       *data;         /* Pointer to DMX channel data */
+extern uint16_t      universe;      /* DMX Universe of last valid packet */
+extern e131_stats_t  stats;         /* Statistics tracker */
 
-e131_packet_t *pwbuff;  /* Pointer to working packet buffer */
-uint8_t       sequence; /* Sequence tracker */
 
-struct netconn *conn;
-struct netbuf *buf;
-char buffer[4096];
-err_t err;
-//LWIP_UNUSED_ARG(arg);
+/* ms clock, sys_now() on the target, supplied by whatever links the core */
+uint32_t E131_now(void);
 
+void E131_init();
 
-uint8_t       *data;                /* Pointer to DMX channel data */
-uint16_t      universe;             /* DMX Universe of last valid packet */
-e131_packet_t *packet;              /* Pointer to last valid packet */
-e131_stats_t  stats;                /* Statistics tracker */
+/* Universe table, covers universe .. universe + n - 1 */
+void E131_setUniverses(uint16_t universe, uint8_t n);
+e131_universe_t *E131_getUniverse(uint16_t universe);
 
+/* First universe and size of the table */
+uint16_t E131_firstUniverse(void);
+uint8_t E131_universeCount(void);
 
-void E131_init();
-void initUnicast();
-void initMulticast(uint16_t universe, uint8_t n);
+void E131_setCallback(e131_callback_t cb);
+void E131_setLossCallback(e131_loss_callback_t cb);
+
+/* Find universes whose sources are gone and run the loss callback on them.
+ * Called every E131_POLL_INTERVAL in the receiving context by the listeners. */
+void E131_poll(uint32_t now);
+
+/* Publish the count slots written to u->wbuff as the universe's data, with
+ * no source behind them, and tell the application */
+void E131_publish(e131_universe_t *u, uint16_t count);
+
+
+/* Parse a datagram held in one buffer, returns the number of DMX channels latched */
+uint16_t E131_parseBuffer(const uint8_t *raw, uint16_t size);
+
+/* Validate a synchronization packet and latch the universes waiting for it */
+uint16_t E131_parseSync(const e131_sync_packet_t *packet, uint16_t size);
+
+/* Route a validated packet to its universe; NULL if the universe is not configured,
+ * the packet is stale, its source finds the source table full or a higher
+ * priority source is in control.
+ * The caller copies the slots to u->target, then calls E131_commit(). */
+e131_universe_t *E131_accept(const e131_packet_t *packet);
 
+/* Source slot for cid, a fresh inactive slot if the source is not tracked yet,
+ * NULL if every slot holds a source heard within E131_SOURCE_TIMEOUT */
+e131_source_t *E131_getSource(e131_universe_t *u, const uint8_t *cid);
 
-/* Generic UDP listener, no physical or IP configuration */
-void E131_begin(e131_listen_t type, uint16_t universe, uint8_t n);
+/* Drop sources silent for E131_SOURCE_TIMEOUT, returns the highest priority left */
+uint8_t E131_arbitrate(e131_universe_t *u, uint32_t now);
 
+/* Number of sources still live after dropping the silent ones */
+uint8_t E131_liveSources(e131_universe_t *u, uint32_t now);
 
-/* Diag functions */
-void dumpError(e131_error_t error);
+/* Publish the count slots written to u->target, returns the number of DMX channels.
+ * Synchronized universes are staged instead and return 0 until their sync packet arrives. */
+uint16_t E131_commit(e131_universe_t *u, uint16_t count);
 
-/* Main packet parser */
-uint16_t E131_parsePacket();
+/* Latch every universe staged for the sync packet's address, returns how many were latched */
+uint8_t E131_sync(const e131_sync_packet_t *packet);
+uint16_t E131_universeNumber(const e131_universe_t *u);
 
 
-/* Packet validater */
-e131_error_t validate();
+/* Packet validater: identifier, vectors, and every PDU length against the
+ * datagram size, so the property values read after it are all inside */
+e131_error_t validate(const e131_packet_t *packet, uint16_t size);
+e131_error_t validateSync(const e131_sync_packet_t *packet, uint16_t size);
+/* Universe discovery packets share the sync packet's root and framing layer header */
+e131_error_t validateDiscovery(const e131_sync_packet_t *packet, uint16_t size);
 
 
 #endif /* E131_H_ */
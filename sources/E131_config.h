@@ -0,0 +1,16 @@
+/*
+ * E131_config.h
+ *
+ *  Sizes the E1.31 core shares with the network stack configuration.
+ *  Included by E131.h and by lwipopts.h, which sizes the IGMP group pool
+ *  from the universe table; holds nothing but plain defines.
+ */
+
+#ifndef E131_CONFIG_H_
+#define E131_CONFIG_H_
+
+#ifndef E131_MAX_UNIVERSES
+#define E131_MAX_UNIVERSES 32           /* Capacity of the universe table */
+#endif
+
+#endif /* E131_CONFIG_H_ */
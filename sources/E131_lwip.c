@@ -0,0 +1,366 @@
+/*
+* E131_lwip.c
+*
+*  lwIP listeners for the E1.31 core: netconn and raw API receive paths,
+*  multicast group membership and the E131_poll() schedule.
+*
+*/
+
+#include "E131_lwip.h"
+#include <string.h>
+#include "lwip/netif.h"
+#include "lwip/tcpip.h"
+#include "lwip/timeouts.h"
+
+/* Bare metal lwIP (NO_SYS, as in the host tools) runs in one context */
+#if NO_SYS
+#define LOCK_TCPIP_CORE()
+#define UNLOCK_TCPIP_CORE()
+#endif
+
+struct netconn *conn;
+struct udp_pcb *pcb;
+struct netbuf *buf;
+err_t err;
+
+
+uint32_t E131_now(void)
+{
+    return sys_now();
+}
+
+#if LWIP_NETCONN
+void initUnicast() {
+    //delay(100);
+	conn = netconn_new(NETCONN_UDP);
+	err = netconn_bind(conn, IP_ADDR_ANY, 5568);
+
+	if(err != ERR_OK)
+	{
+		PRINTF("NETCONN BIND FAIL\r\n");
+		return;
+	}
+
+	/* Return to E131_parsePacket() now and then for E131_poll() */
+	netconn_set_recvtimeout(conn, E131_POLL_INTERVAL);
+
+    PRINTF("- Unicast port: %d\r\n", E131_DEFAULT_PORT);
+
+}
+#endif
+
+static void E131_recv(void *arg, struct udp_pcb *upcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(upcb);
+    LWIP_UNUSED_ARG(addr);
+    LWIP_UNUSED_ARG(port);
+
+    E131_parsePbuf(p);
+    pbuf_free(p);
+}
+
+static void E131_service(uint32_t now);
+
+/* lwIP timeout in the tcpip thread, alongside E131_recv() */
+static void E131_tick(void *arg)
+{
+    LWIP_UNUSED_ARG(arg);
+
+    E131_service(sys_now());
+    sys_timeout(E131_POLL_INTERVAL, E131_tick, NULL);
+}
+
+void initUnicastRaw() {
+    LOCK_TCPIP_CORE();
+    pcb = udp_new();
+    if (pcb)
+    {
+        err = udp_bind(pcb, IP_ADDR_ANY, E131_DEFAULT_PORT);
+        if (err == ERR_OK)
+        {
+            udp_recv(pcb, E131_recv, NULL);
+            sys_timeout(E131_POLL_INTERVAL, E131_tick, NULL);
+        }
+    }
+    else
+    {
+        err = ERR_MEM;
+    }
+    UNLOCK_TCPIP_CORE();
+
+    if (err != ERR_OK)
+    {
+        PRINTF("UDP BIND FAIL\r\n");
+        return;
+    }
+
+    PRINTF("- Unicast port: %d (raw)\r\n", E131_DEFAULT_PORT);
+}
+
+/* Universe range currently subscribed, empty until multicast is started.
+ * Only groups whose join succeeded are marked, the rest are retried at the next subscribe. */
+static uint16_t mcast_first;
+static uint8_t  mcast_count;
+static uint8_t  mcast_enabled;
+static uint8_t  mcast_joined[E131_MAX_UNIVERSES];
+static uint16_t mcast_sync;         /* Sync universe joined outside the range, 0 if none */
+
+static void E131_groupAddress(ip4_addr_t *group, uint16_t universe)
+{
+    IP4_ADDR(group, 239, 255, ((universe >> 8) & 0xff), ((universe >> 0) & 0xff));
+}
+
+static uint8_t E131_inRange(uint16_t universe)
+{
+    return (uint16_t)(universe - mcast_first) < mcast_count;
+}
+
+/* Leave the groups that drop out of the subscribed range and join the new ones.
+ * Returns the first join error, ERR_OK if every group of the range is joined.
+ * Must be called with the tcpip core locked. */
+static err_t E131_subscribe(uint16_t universe, uint8_t n)
+{
+    uint8_t joined[E131_MAX_UNIVERSES];
+    ip4_addr_t group;
+    err_t result = ERR_OK;
+
+    for (uint8_t i = 0; i < mcast_count; i++) {
+        uint16_t u = mcast_first + i;
+
+        if ((uint16_t)(u - universe) >= n && mcast_joined[i]) {
+            E131_groupAddress(&group, u);
+            igmp_leavegroup(IP4_ADDR_ANY, &group);
+        }
+    }
+
+    for (uint8_t i = 0; i < n; i++) {
+        uint16_t u = universe + i;
+        err_t e;
+
+        if (E131_inRange(u) && mcast_joined[(uint16_t)(u - mcast_first)]) {
+            joined[i] = 1;
+            continue;
+        }
+
+        /* The sync universe may already be joined on its own */
+        if (u == mcast_sync) {
+            mcast_sync = 0;
+            joined[i] = 1;
+            continue;
+        }
+
+        E131_groupAddress(&group, u);
+        e = igmp_joingroup(IP4_ADDR_ANY, &group);
+        joined[i] = e == ERR_OK;
+        if (e != ERR_OK && result == ERR_OK) {
+            PRINTF("IGMP JOIN FAIL: %u\r\n", u);
+            result = e;
+        }
+    }
+
+    mcast_first = universe;
+    mcast_count = n;
+    memcpy(mcast_joined, joined, n);
+    return result;
+}
+
+/* Follow the synchronization universe the received data points at: its sync
+ * packets go to that universe's group, which may lie outside the range.
+ * Must be called with the tcpip core locked. */
+static void E131_subscribeSync(void)
+{
+    uint16_t address = 0;
+    ip4_addr_t group;
+
+    for (uint8_t i = 0; i < E131_universeCount() && !address; i++)
+        address = E131_getUniverse(E131_firstUniverse() + i)->sync_address;
+
+    if (address == mcast_sync || (address && E131_inRange(address)))
+        return;
+
+    if (mcast_sync) {
+        E131_groupAddress(&group, mcast_sync);
+        igmp_leavegroup(IP4_ADDR_ANY, &group);
+        mcast_sync = 0;
+    }
+    if (address) {
+        E131_groupAddress(&group, address);
+        if (igmp_joingroup(IP4_ADDR_ANY, &group) == ERR_OK)
+            mcast_sync = address;
+        else
+            PRINTF("IGMP JOIN FAIL: %u (sync)\r\n", address);
+    }
+}
+
+/* Periodic work of both listeners, with the tcpip core locked */
+static void E131_service(uint32_t now)
+{
+    E131_poll(now);
+    if (mcast_enabled)
+        E131_subscribeSync();
+}
+
+void initMulticast(uint16_t universe, uint8_t n) {
+	ip4_addr_t address;
+	err_t e;
+
+	if (n > E131_MAX_UNIVERSES)
+		n = E131_MAX_UNIVERSES;
+
+	/* The listener is bound to any address, joining the groups is all that is left */
+	LOCK_TCPIP_CORE();
+	e = E131_subscribe(universe, n);
+	mcast_enabled = 1;
+	UNLOCK_TCPIP_CORE();
+
+	E131_groupAddress(&address, universe);
+    PRINTF("- Universe: %u (%u)%s\r\n", universe, n, e == ERR_OK ? "" : " not all joined");
+    PRINTF("- Multicast address: ");
+    PRINTF(" %u.%u.%u.%u\r\n", ((u8_t *)&address)[0], ((u8_t *)&address)[1],
+           ((u8_t *)&address)[2], ((u8_t *)&address)[3]);
+
+}
+
+err_t E131_setRange(uint16_t universe, uint8_t n)
+{
+    err_t e = ERR_OK;
+
+    if (n > E131_MAX_UNIVERSES)
+        n = E131_MAX_UNIVERSES;
+
+    LOCK_TCPIP_CORE();
+    E131_setUniverses(universe, n);
+    if (mcast_enabled)
+        e = E131_subscribe(universe, n);
+    UNLOCK_TCPIP_CORE();
+
+    return e;
+}
+
+#if LWIP_NETCONN
+void E131_begin(e131_listen_t type, uint16_t universe, uint8_t n) {
+    if (n)
+        E131_setUniverses(universe, n);
+    initUnicast();
+    if (type == E131_MULTICAST)
+        initMulticast(E131_firstUniverse(), E131_universeCount());
+}
+#endif
+
+void E131_beginRaw(e131_listen_t type, uint16_t universe, uint8_t n) {
+    if (n)
+        E131_setUniverses(universe, n);
+    initUnicastRaw();
+    if (type == E131_MULTICAST)
+        initMulticast(E131_firstUniverse(), E131_universeCount());
+}
+
+void dumpError(e131_error_t error, const e131_packet_t *packet) {
+    switch (error) {
+    	case ERROR_NONE:
+    		break;
+        case ERROR_ACN_ID:
+        	PRINTF("INVALID PACKET ID: ");
+            for (uint8_t i = 0; i < sizeof(ACN_ID); i++)
+            	PRINTF("%02X", packet->acn_id[i]);
+            PRINTF("\r\n");
+            break;
+        case ERROR_PACKET_SIZE:
+        	PRINTF("INVALID PACKET SIZE: \r\n");
+            break;
+        case ERROR_VECTOR_ROOT:
+        	PRINTF("INVALID ROOT VECTOR: 0x \r\n");
+            //Serial.println(htonl(pwbuff->root_vector), HEX);
+            break;
+        case ERROR_VECTOR_FRAME:
+        	PRINTF("INVALID FRAME VECTOR: 0x");
+            //Serial.println(htonl(pwbuff->frame_vector), HEX);
+            break;
+        case ERROR_VECTOR_DMP:
+        	PRINTF("INVALID DMP VECTOR: 0x");
+        	PRINTF("%02X\r\n", packet->dmp_vector);
+            break;
+        case ERROR_SYNC:
+        	PRINTF("INVALID SYNC ADDRESS\r\n");
+    }
+}
+
+#if LWIP_NETCONN
+uint16_t E131_parsePacket()
+{
+    static uint32_t polled;         /* sys_now() of the last E131_poll() */
+    uint16_t retval = 0;
+
+    err = netconn_recv(conn, &buf);
+    if (err == ERR_OK)
+    {
+        retval = E131_parsePbuf(buf->p);
+
+        PRINTF("PR: %d   PE: %d     SE: %d\r", stats.num_packets, stats.packet_errors, stats.sequence_errors);
+
+        netbuf_delete(buf);
+    }
+
+    if (sys_now() - polled >= E131_POLL_INTERVAL)
+    {
+        polled = sys_now();
+        LOCK_TCPIP_CORE();
+        E131_service(polled);
+        UNLOCK_TCPIP_CORE();
+    }
+
+    return retval;
+}
+#endif
+
+uint16_t E131_parsePbuf(struct pbuf *p)
+{
+    static uint8_t hbuff[E131_DMP_DATA + 1];    /* Header and start code of a chained packet */
+    const e131_packet_t *packet;
+    e131_universe_t *u;
+    e131_error_t error;
+    uint16_t count;
+
+    if (p->tot_len < E131_SYNC_SIZE)
+    {
+        stats.packet_errors++;
+        return 0;
+    }
+
+    /* Validate in place; only a header split across pbufs is gathered */
+    if (p->len > E131_DMP_DATA || p->len == p->tot_len)
+    {
+        packet = (const e131_packet_t *)p->payload;
+    }
+    else
+    {
+        pbuf_copy_partial(p, hbuff, sizeof(hbuff), 0);
+        packet = (const e131_packet_t *)hbuff;
+    }
+
+    if (htonl(packet->root_vector) == VECTOR_ROOT_EXTENDED)
+        return E131_parseSync((const e131_sync_packet_t *)packet, p->tot_len);
+
+    error = validate(packet, p->tot_len);
+    if (error)
+    {
+        //dumpError(error, packet);
+        stats.packet_errors++;
+        return 0;
+    }
+
+    u = E131_accept(packet);
+    if (!u)
+        return 0;
+
+    /* The one copy of the slot data, straight into the universe buffer */
+    count = htons(packet->property_value_count);
+    if (p->len >= E131_DMP_DATA + count)
+        memcpy(u->target, packet->property_values, count);
+    else
+        pbuf_copy_partial(p, u->target, count, E131_DMP_DATA);
+
+    return E131_commit(u, count);
+}
+
@@ -0,0 +1,57 @@
+/*
+* E131_lwip.h
+*
+*  lwIP listeners for the E1.31 core.
+*
+*/
+
+#ifndef E131_LWIP_H_
+#define E131_LWIP_H_
+
+#include "E131.h"
+
+#include "fsl_debug_console.h"
+
+#include <lwip/ip_addr.h>
+#include <lwip/igmp.h>
+#include "lwip/opt.h"
+#include "lwip/api.h"
+#include "lwip/sys.h"
+#include "lwip/udp.h"
+
+
+extern struct netconn *conn;
+extern struct udp_pcb *pcb;
+extern struct netbuf *buf;
+extern err_t err;
+
+
+/* The netconn listener needs LWIP_NETCONN, the raw one works without an OS as well */
+void initUnicast();
+void initUnicastRaw();
+/* Join the groups of the universe range, then of the sync universe its data names */
+void initMulticast(uint16_t universe, uint8_t n);
+
+/* Change the universe range at runtime, following with the multicast groups if listening to multicast.
+ * Returns the first IGMP join error, groups that failed are retried by the next call.
+ * In netconn mode call it from the task running E131_parsePacket(). */
+err_t E131_setRange(uint16_t universe, uint8_t n);
+
+/* Generic UDP listener, no physical or IP configuration */
+void E131_begin(e131_listen_t type, uint16_t universe, uint8_t n);
+
+/* Raw API listener, packets are parsed and dispatched from the tcpip thread */
+void E131_beginRaw(e131_listen_t type, uint16_t universe, uint8_t n);
+
+
+/* Diag functions */
+void dumpError(e131_error_t error, const e131_packet_t *packet);
+
+/* Main packet parser */
+uint16_t E131_parsePacket();
+
+/* Parse a received datagram in place, copying only its slots into the universe table */
+uint16_t E131_parsePbuf(struct pbuf *p);
+
+
+#endif /* E131_LWIP_H_ */
@@ -0,0 +1,144 @@
+/*
+ * apa102.c
+ *
+ *  APA102/SK9822 frame builder.
+ */
+
+#include <string.h>
+
+#include "apa102.h"
+
+size_t APA102_Begin(uint8_t *frame)
+{
+    memset(frame, 0, APA102_START_BYTES);
+    return APA102_START_BYTES;
+}
+
+/*
+ * Encode 'pixels' RGB triples into APA102 pixel words at 'dst'.  The light
+ * output of each component is c / 255 * brightness / 31; the header is the
+ * smallest current that can still reach the brightest component and the
+ * components are scaled up to match.
+ */
+void APA102_EncodePixels(const uint8_t *rgb, size_t pixels, uint8_t brightness, uint8_t *dst)
+{
+    uint32_t r, g, b, m, h;
+    size_t i;
+
+    if (brightness > APA102_BRIGHTNESS_MAX)
+        brightness = APA102_BRIGHTNESS_MAX;
+
+    for (i = 0; i < pixels; i++) {
+        r = rgb[0];
+        g = rgb[1];
+        b = rgb[2];
+        rgb += 3;
+
+        m = r > g ? r : g;
+        m = m > b ? m : b;
+
+        /* h = ceil(m * brightness / 255), at least 1 */
+        h = (m * brightness + 254U) / 255U;
+        if (h == 0) {
+            dst[0] = 0xE0 | 1;
+            dst[1] = 0;
+            dst[2] = 0;
+            dst[3] = 0;
+            dst += 4;
+            continue;
+        }
+
+        /* c * brightness / h, rounded to nearest and at most 255; the M4
+         * divides in a few cycles, so there is no reciprocal table */
+        r = (r * brightness * 2U + h) / (h * 2U);
+        g = (g * brightness * 2U + h) / (h * 2U);
+        b = (b * brightness * 2U + h) / (h * 2U);
+
+        dst[0] = (uint8_t)(0xE0 | h);
+        dst[1] = (uint8_t)(b > 255 ? 255 : b);
+        dst[2] = (uint8_t)(g > 255 ? 255 : g);
+        dst[3] = (uint8_t)(r > 255 ? 255 : r);
+        dst += 4;
+    }
+}
+
+/*
+ * The same from 16 bit levels, scaled by 'scale' / 65536 on the way.  The
+ * header comes from the 16 bit maximum, so a level too dim for 8 bits at
+ * full current still gets a low current and a non-zero PWM value.
+ */
+void APA102_EncodePixels16(const uint16_t *rgb, size_t pixels, uint8_t brightness, uint32_t scale, uint8_t *dst)
+{
+    uint32_t r, g, b, m, h;
+    size_t i;
+
+    if (brightness > APA102_BRIGHTNESS_MAX)
+        brightness = APA102_BRIGHTNESS_MAX;
+    if (scale > 65536U)
+        scale = 65536U;
+
+    for (i = 0; i < pixels; i++) {
+        r = (rgb[0] * scale) >> 16;
+        g = (rgb[1] * scale) >> 16;
+        b = (rgb[2] * scale) >> 16;
+        rgb += 3;
+
+        m = r > g ? r : g;
+        m = m > b ? m : b;
+
+        /* h = ceil(m * brightness / 65535), m >> 11 at full brightness */
+        h = (m * brightness + 65534U) / 65535U;
+        if (h == 0) {
+            dst[0] = 0xE0 | 1;
+            dst[1] = 0;
+            dst[2] = 0;
+            dst[3] = 0;
+            dst += 4;
+            continue;
+        }
+
+        /* c * brightness * 255 / 65535 / h, rounded to nearest */
+        r = (r * brightness * 510U + h * 65535U) / (h * 131070U);
+        g = (g * brightness * 510U + h * 65535U) / (h * 131070U);
+        b = (b * brightness * 510U + h * 65535U) / (h * 131070U);
+
+        dst[0] = (uint8_t)(0xE0 | h);
+        dst[1] = (uint8_t)(b > 255 ? 255 : b);
+        dst[2] = (uint8_t)(g > 255 ? 255 : g);
+        dst[3] = (uint8_t)(r > 255 ? 255 : r);
+        dst += 4;
+    }
+}
+
+size_t APA102_End(size_t pixels, uint8_t *dst)
+{
+    size_t n = APA102_END_BYTES(pixels);
+
+    memset(dst, 0, n);
+    return n;
+}
+
+/* Build a whole frame, 'frame' must hold APA102_FRAME_BYTES(pixels) */
+size_t APA102_Encode(const uint8_t *rgb, size_t pixels, uint8_t brightness, uint8_t *frame)
+{
+    uint8_t *p = frame;
+
+    p += APA102_Begin(p);
+    APA102_EncodePixels(rgb, pixels, brightness, p);
+    p += pixels * APA102_PIXEL_BYTES;
+    p += APA102_End(pixels, p);
+
+    return (size_t)(p - frame);
+}
+
+size_t APA102_Encode16(const uint16_t *rgb, size_t pixels, uint8_t brightness, uint32_t scale, uint8_t *frame)
+{
+    uint8_t *p = frame;
+
+    p += APA102_Begin(p);
+    APA102_EncodePixels16(rgb, pixels, brightness, scale, p);
+    p += pixels * APA102_PIXEL_BYTES;
+    p += APA102_End(pixels, p);
+
+    return (size_t)(p - frame);
+}
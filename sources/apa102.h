@@ -0,0 +1,69 @@
+/*
+ * apa102.h
+ *
+ *  APA102/SK9822 clocked pixel output.
+ *
+ *  A frame is a 32 bit start frame of zeros, one 32 bit word per pixel
+ *  (111 + 5 bit brightness, blue, green, red) and an end frame.  The end
+ *  frame is a zero word, which SK9822 needs to latch, followed by at least
+ *  one clock per two pixels to push the data through the chain.
+ *
+ *  The 5 bit brightness field is picked per pixel: dim pixels get a low
+ *  current and high PWM values instead of a full current and a few PWM
+ *  steps, which keeps their color resolution and lowers flicker.  Encoded
+ *  from 16 bit levels the header also adds the range 8 bit channels lack:
+ *  levels that would round to 0 or 1 still come out at a low current.
+ *
+ *  The frame builder has no hardware dependencies and is built on the host
+ *  by the unit tests.
+ */
+
+#ifndef APA102_H_
+#define APA102_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define APA102_BRIGHTNESS_MAX 31
+#define APA102_START_BYTES 4
+#define APA102_PIXEL_BYTES 4
+#define APA102_END_BYTES(pixels) (4U + (((pixels) + 31U) / 32U) * 2U)
+#define APA102_FRAME_BYTES(pixels) (APA102_START_BYTES + (pixels) * APA102_PIXEL_BYTES + APA102_END_BYTES(pixels))
+
+#ifndef APA102_MAX_PIXELS
+#define APA102_MAX_PIXELS 510           /* Three full universes of RGB */
+#endif
+#ifndef APA102_BAUD
+#define APA102_BAUD 8000000U            /* Upper bound on SCK */
+#endif
+
+/* Output hardware */
+#ifndef APA102_SPI
+#define APA102_SPI SPI1
+#define APA102_SPI_CLOCK kCLOCK_Spi1
+#define APA102_PORT PORTE
+#define APA102_PORT_CLOCK kCLOCK_PortE
+#define APA102_SCK_PIN 2U               /* PTE2 = SPI1_SCK on Alt2 */
+#define APA102_SOUT_PIN 1U              /* PTE1 = SPI1_SOUT on Alt2 */
+#define APA102_PIN_MUX kPORT_MuxAlt2
+#define APA102_DMA_CHANNEL 6U
+#define APA102_DMA_SOURCE kDmaRequestMux0SPI1
+#define APA102_DMA_HANDLER DMA6_IRQHandler
+#endif
+
+size_t APA102_Begin(uint8_t *frame);
+void APA102_EncodePixels(const uint8_t *rgb, size_t pixels, uint8_t brightness, uint8_t *dst);
+size_t APA102_End(size_t pixels, uint8_t *dst);
+size_t APA102_Encode(const uint8_t *rgb, size_t pixels, uint8_t brightness, uint8_t *frame);
+
+/* The same from 16 bit RGB levels, scaled by 'scale' / 65536 */
+void APA102_EncodePixels16(const uint16_t *rgb, size_t pixels, uint8_t brightness, uint32_t scale, uint8_t *dst);
+size_t APA102_Encode16(const uint16_t *rgb, size_t pixels, uint8_t brightness, uint32_t scale, uint8_t *frame);
+
+/* DSPI + DMA driver */
+void APA102_Init(void);
+bool APA102_Show(const uint8_t *frame, size_t bytes);
+bool APA102_IsBusy(void);
+
+#endif /* APA102_H_ */
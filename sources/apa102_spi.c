@@ -0,0 +1,96 @@
+/*
+ * apa102_spi.c
+ *
+ *  APA102/SK9822 driver: DSPI master with 16 bit frames, fed by DMA from a
+ *  buffer of PUSHR words (command in the top half, two frame bytes in the
+ *  bottom half).  The DMA major loop interrupt frees the buffer for the
+ *  next frame; the last words drain from the FIFO on their own.
+ */
+
+#include "apa102.h"
+#include "dma_chan.h"
+
+#include "fsl_clock.h"
+#include "fsl_port.h"
+
+#define APA102_SOURCE_CLOCK CLOCK_GetFreq(kCLOCK_BusClk)
+#define APA102_WORDS ((APA102_FRAME_BYTES(APA102_MAX_PIXELS) + 1U) / 2U)
+
+static uint32_t pushr[APA102_WORDS];
+static volatile bool busy;
+
+void APA102_DMA_HANDLER(void)
+{
+    DMACHAN_ClearInterrupt(APA102_DMA_CHANNEL);
+    busy = false;
+}
+
+void APA102_Init(void)
+{
+    static const uint8_t scalers[] = { 2, 4, 6, 8, 16, 32, 64, 128 };
+    uint32_t clock;
+    uint32_t br;
+
+    CLOCK_EnableClock(APA102_PORT_CLOCK);
+    PORT_SetPinMux(APA102_PORT, APA102_SCK_PIN, APA102_PIN_MUX);
+    PORT_SetPinMux(APA102_PORT, APA102_SOUT_PIN, APA102_PIN_MUX);
+    CLOCK_EnableClock(APA102_SPI_CLOCK);
+
+    /* SCK = bus / 2 / scaler, the fastest not above APA102_BAUD */
+    clock = APA102_SOURCE_CLOCK / 2U;
+    for (br = 0; br < sizeof(scalers) - 1U; br++)
+        if (clock / scalers[br] <= APA102_BAUD)
+            break;
+
+    APA102_SPI->MCR = SPI_MCR_MSTR_MASK | SPI_MCR_HALT_MASK | SPI_MCR_DIS_RXF_MASK | SPI_MCR_CLR_TXF_MASK |
+                      SPI_MCR_CLR_RXF_MASK | SPI_MCR_PCSIS(0x3F);
+    APA102_SPI->CTAR[0] = SPI_CTAR_FMSZ(15) | SPI_CTAR_PBR(0) | SPI_CTAR_BR(br);
+    APA102_SPI->RSER = SPI_RSER_TFFF_RE_MASK | SPI_RSER_TFFF_DIRS_MASK;
+    APA102_SPI->MCR &= ~SPI_MCR_HALT_MASK;
+
+    DMACHAN_Init();
+}
+
+bool APA102_IsBusy(void)
+{
+    return busy;
+}
+
+/*
+ * Start sending a frame built by APA102_Encode() or APA102_Encode16().
+ * Returns false without touching the strip if the previous frame is still
+ * being pushed.
+ */
+bool APA102_Show(const uint8_t *frame, size_t bytes)
+{
+    dmachan_transfer_t transfer;
+    size_t words;
+    size_t i;
+
+    if (busy)
+        return false;
+
+    words = bytes / 2U;
+    if (words > APA102_WORDS)
+        words = APA102_WORDS;
+    if (words == 0)
+        return true;
+
+    for (i = 0; i < words; i++)
+        pushr[i] = SPI_PUSHR_CTAS(0) | SPI_PUSHR_TXDATA(((uint32_t)frame[2 * i] << 8) | frame[2 * i + 1]);
+
+    transfer.source = (uint8_t)APA102_DMA_SOURCE;
+    transfer.src = pushr;
+    transfer.srcOffset = sizeof(pushr[0]);
+    transfer.srcSize = kDMACHAN_Size32;
+    transfer.dst = &APA102_SPI->PUSHR;
+    transfer.dstOffset = 0;
+    transfer.dstSize = kDMACHAN_Size32;
+    transfer.count = (uint16_t)words;
+    transfer.interrupt = true;
+
+    busy = true;
+    DMACHAN_Start(APA102_DMA_CHANNEL, &transfer);
+
+    return true;
+}
@@ -0,0 +1,54 @@
+/*
+ * color_lut.c
+ *
+ *  Gamma and white balance lookup tables for the pixel outputs.
+ */
+
+#include <math.h>
+
+#include "color_lut.h"
+
+/* Fill one component table scaled to 'max' */
+static void COLORLUT_curve(float gamma, uint8_t white, float max, uint16_t *t16, uint8_t *t8)
+{
+    float scale = max * white / 255.0f;
+    uint32_t v;
+    int i;
+
+    for (i = 0; i < 256; i++) {
+        v = (uint32_t)(powf(i / 255.0f, gamma) * scale + 0.5f);
+        if (t16)
+            t16[i] = (uint16_t)v;
+        else
+            t8[i] = (uint8_t)v;
+    }
+}
+
+void COLORLUT_Build8(color_lut8_t *lut, const color_correction_t *cc)
+{
+    COLORLUT_curve(cc->gamma, cc->white[0], 255.0f, NULL, lut->r);
+    COLORLUT_curve(cc->gamma, cc->white[1], 255.0f, NULL, lut->g);
+    COLORLUT_curve(cc->gamma, cc->white[2], 255.0f, NULL, lut->b);
+    COLORLUT_curve(cc->gamma, cc->white[3], 255.0f, NULL, lut->w);
+}
+
+void COLORLUT_Build16(color_lut16_t *lut, const color_correction_t *cc)
+{
+    COLORLUT_curve(cc->gamma, cc->white[0], 65535.0f, lut->r, NULL);
+    COLORLUT_curve(cc->gamma, cc->white[1], 65535.0f, lut->g, NULL);
+    COLORLUT_curve(cc->gamma, cc->white[2], 65535.0f, lut->b, NULL);
+    COLORLUT_curve(cc->gamma, cc->white[3], 65535.0f, lut->w, NULL);
+}
+
+void COLORLUT_Apply8(const color_lut8_t *lut, const uint8_t *src, size_t pixels, uint8_t *dst)
+{
+    size_t i;
+
+    for (i = 0; i < pixels; i++) {
+        dst[0] = lut->r[src[0]];
+        dst[1] = lut->g[src[1]];
+        dst[2] = lut->b[src[2]];
+        src += 3;
+        dst += 3;
+    }
+}
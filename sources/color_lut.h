@@ -0,0 +1,49 @@
+/*
+ * color_lut.h
+ *
+ *  Gamma and white balance lookup tables for the pixel outputs.
+ *
+ *  A table maps each 8 bit DMX level to the output level of one color:
+ *  out = max * white / 255 * (in / 255) ^ gamma.  Tables are built once
+ *  when an output is configured and applied with one load per component
+ *  while the frame is encoded.
+ *
+ *  No hardware dependencies, built on the host by the tests and benchmark.
+ */
+
+#ifndef COLOR_LUT_H_
+#define COLOR_LUT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct _color_lut8
+{
+    uint8_t r[256];
+    uint8_t g[256];
+    uint8_t b[256];
+    uint8_t w[256];
+} color_lut8_t;
+
+/* 16 bit output for stages that keep more depth than the pixels have */
+typedef struct _color_lut16
+{
+    uint16_t r[256];
+    uint16_t g[256];
+    uint16_t b[256];
+    uint16_t w[256];
+} color_lut16_t;
+
+typedef struct _color_correction
+{
+    float gamma;                        /* 1.0 is linear, LEDs want 2.2 - 2.8 */
+    uint8_t white[4];                   /* Full scale of red, green, blue and white */
+} color_correction_t;
+
+void COLORLUT_Build8(color_lut8_t *lut, const color_correction_t *cc);
+void COLORLUT_Build16(color_lut16_t *lut, const color_correction_t *cc);
+
+/* Corrected RGB triples, dst may equal src */
+void COLORLUT_Apply8(const color_lut8_t *lut, const uint8_t *src, size_t pixels, uint8_t *dst);
+
+#endif /* COLOR_LUT_H_ */
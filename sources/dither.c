@@ -0,0 +1,33 @@
+/*
+ * dither.c
+ *
+ *  Temporal dithering of 16 bit channel values onto 8 bit pixels.
+ */
+
+#include "dither.h"
+
+/* 0..65535 onto 0..255 in 8.8 fixed point, 257 * k becomes exactly k.0 */
+#define DITHER_SCALE(v) ((uint32_t)(v) - ((uint32_t)(v) >> 8))
+
+void DITHER_Apply(const uint16_t *src, uint8_t *residual, size_t n, uint32_t scale, uint8_t *dst)
+{
+    uint32_t acc;
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        acc = DITHER_SCALE((src[i] * scale) >> 16) + residual[i];
+        dst[i] = (uint8_t)(acc >> 8);
+        residual[i] = (uint8_t)acc;
+    }
+}
+
+void DITHER_Round(const uint16_t *src, size_t n, uint32_t scale, uint8_t *dst)
+{
+    uint32_t v;
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        v = (DITHER_SCALE((src[i] * scale) >> 16) + 128U) >> 8;
+        dst[i] = (uint8_t)(v > 255U ? 255U : v);
+    }
+}
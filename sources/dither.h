@@ -0,0 +1,31 @@
+/*
+ * dither.h
+ *
+ *  Temporal dithering of 16 bit channel values onto 8 bit pixels.
+ *
+ *  Each channel carries the fraction that didn't fit in 8 bits over to
+ *  the next refresh, so over a run of refreshes the average output equals
+ *  the 16 bit value.  Values that are exact 8 bit levels (multiples of
+ *  257) never flicker.
+ *
+ *  Both passes scale the values on the way, by 'scale' / DITHER_UNITY, for
+ *  the current limiting to cost no pass of its own.
+ *
+ *  No hardware dependencies, built on the host by the tests.
+ */
+
+#ifndef DITHER_H_
+#define DITHER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DITHER_UNITY 65536U             /* Scale that leaves the values alone */
+
+/* 'n' channels of src into dst, 'residual' holds the carried fractions */
+void DITHER_Apply(const uint16_t *src, uint8_t *residual, size_t n, uint32_t scale, uint8_t *dst);
+
+/* Same without carrying, rounded to nearest */
+void DITHER_Round(const uint16_t *src, size_t n, uint32_t scale, uint8_t *dst);
+
+#endif /* DITHER_H_ */
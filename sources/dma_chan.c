@@ -0,0 +1,82 @@
+/*
+ * dma_chan.c
+ *
+ *  Minimal eDMA/DMAMUX channel helper for the output drivers.
+ */
+
+#include "dma_chan.h"
+#include "fsl_clock.h"
+
+/* Request sources in the device header carry the mux instance in bit 8 */
+#define DMACHAN_SOURCE(x) ((x) & 0xFFU)
+
+void DMACHAN_Init(void)
+{
+    static bool initialized;
+
+    if (initialized)
+        return;
+    initialized = true;
+
+    CLOCK_EnableClock(kCLOCK_Dmamux0);
+    CLOCK_EnableClock(kCLOCK_Dma0);
+
+    /* Fixed priority arbitration, halt on error off, minor loop mapping off */
+    DMA0->CR = 0;
+}
+
+void DMACHAN_Start(uint32_t channel, const dmachan_transfer_t *transfer)
+{
+    uint16_t csr;
+
+    DMACHAN_Init();
+
+    DMA0->CERQ = DMA_CERQ_CERQ(channel);
+    if (transfer->source)
+        DMAMUX->CHCFG[channel] = 0;
+    DMA0->CDNE = DMA_CDNE_CDNE(channel);
+    DMA0->CERR = DMA_CERR_CERR(channel);
+    DMA0->CINT = DMA_CINT_CINT(channel);
+
+    DMA0->TCD[channel].SADDR = (uint32_t)transfer->src;
+    DMA0->TCD[channel].SOFF = (uint16_t)transfer->srcOffset;
+    DMA0->TCD[channel].ATTR = DMA_ATTR_SSIZE(transfer->srcSize) | DMA_ATTR_DSIZE(transfer->dstSize);
+    DMA0->TCD[channel].NBYTES_MLNO = 1U << transfer->srcSize;
+    DMA0->TCD[channel].SLAST = 0;
+    DMA0->TCD[channel].DADDR = (uint32_t)transfer->dst;
+    DMA0->TCD[channel].DOFF = (uint16_t)transfer->dstOffset;
+    DMA0->TCD[channel].CITER_ELINKNO = DMA_CITER_ELINKNO_CITER(transfer->count);
+    DMA0->TCD[channel].BITER_ELINKNO = DMA_BITER_ELINKNO_BITER(transfer->count);
+    DMA0->TCD[channel].DLAST_SGA = 0;
+
+    /* Drop the request when the major loop ends so the peripheral can't
+     * pull the channel past the end of the buffer */
+    csr = DMA_CSR_DREQ_MASK;
+    if (transfer->interrupt)
+        csr |= DMA_CSR_INTMAJOR_MASK;
+    DMA0->TCD[channel].CSR = csr;
+
+    if (transfer->source)
+        DMAMUX->CHCFG[channel] = DMAMUX_CHCFG_ENBL_MASK | DMAMUX_CHCFG_SOURCE(DMACHAN_SOURCE(transfer->source));
+
+    if (transfer->interrupt)
+        EnableIRQ((IRQn_Type)(DMA0_IRQn + channel));
+
+    DMA0->SERQ = DMA_SERQ_SERQ(channel);
+}
+
+void DMACHAN_Stop(uint32_t channel)
+{
+    DMA0->CERQ = DMA_CERQ_CERQ(channel);
+    DMA0->CINT = DMA_CINT_CINT(channel);
+}
+
+bool DMACHAN_IsDone(uint32_t channel)
+{
+    return (DMA0->TCD[channel].CSR & DMA_CSR_DONE_MASK) != 0;
+}
+
+void DMACHAN_ClearInterrupt(uint32_t channel)
+{
+    DMA0->CINT = DMA_CINT_CINT(channel);
+}
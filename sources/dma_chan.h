@@ -0,0 +1,44 @@
+/*
+ * dma_chan.h
+ *
+ *  Minimal eDMA/DMAMUX channel helper for the output drivers.
+ *
+ *  The SDK drop in this project has no fsl_edma/fsl_dmamux drivers, so
+ *  this programs the TCDs directly.  Each output owns a fixed channel;
+ *  a transfer is a single major loop of 'count' elements moved one per
+ *  peripheral request.
+ */
+
+#ifndef DMA_CHAN_H_
+#define DMA_CHAN_H_
+
+#include "fsl_common.h"
+
+/* Element sizes, encoded as the TCD ATTR size field */
+typedef enum _dmachan_size
+{
+    kDMACHAN_Size8 = 0U,
+    kDMACHAN_Size16 = 1U,
+    kDMACHAN_Size32 = 2U,
+} dmachan_size_t;
+
+typedef struct _dmachan_transfer
+{
+    uint8_t source;             /* DMAMUX request source, 0 to leave the mux alone */
+    const volatile void *src;   /* First source element */
+    int16_t srcOffset;          /* Bytes added to src after each element */
+    dmachan_size_t srcSize;
+    volatile void *dst;         /* First destination element */
+    int16_t dstOffset;          /* Bytes added to dst after each element */
+    dmachan_size_t dstSize;
+    uint16_t count;             /* Elements in the major loop, 1..32767 */
+    bool interrupt;             /* Raise DMAn_IRQn on completion */
+} dmachan_transfer_t;
+
+void DMACHAN_Init(void);
+void DMACHAN_Start(uint32_t channel, const dmachan_transfer_t *transfer);
+void DMACHAN_Stop(uint32_t channel);
+bool DMACHAN_IsDone(uint32_t channel);
+void DMACHAN_ClearInterrupt(uint32_t channel);
+
+#endif /* DMA_CHAN_H_ */
@@ -0,0 +1,222 @@
+/*
+ * dmx_uart.c
+ *
+ *  DMX512 output on the UARTs.
+ */
+
+#include "dmx_uart.h"
+
+#if DMX_PORTS > 0
+
+#include <string.h>
+
+#include "dma_chan.h"
+
+#include "fsl_clock.h"
+#include "fsl_port.h"
+#include "fsl_uart.h"
+
+#if DMX_PORTS > 2
+#error "Only UART1 and UART4 are wired up as DMX ports"
+#endif
+
+typedef struct _dmx_port_config
+{
+    UART_Type *base;
+    clock_name_t clock;                 /* UART0/1 run from the system clock, the rest from the bus */
+    IRQn_Type irq;
+    uint8_t dmaSource;
+    PORT_Type *port;
+    clock_ip_name_t portClock;
+    uint32_t pin;
+    port_mux_t mux;
+} dmx_port_config_t;
+
+typedef enum _dmx_state
+{
+    kDMX_Break,                         /* 0x00 going out at the break rate */
+    kDMX_Data,                          /* DMA feeding slots */
+    kDMX_Drain,                         /* Waiting for the last slot to leave the shifter */
+} dmx_state_t;
+
+typedef struct _dmx_port
+{
+    const dmx_port_config_t *config;
+    uint8_t buff[2][DMX_FRAME_SIZE];
+    uint8_t front;                      /* Buffer being sent */
+    volatile uint8_t fresh;             /* Back buffer holds newer data */
+    volatile uint8_t writing;           /* DMX_Update() is filling the back buffer */
+    dmx_state_t state;
+    uint8_t dataBaud[3];                /* BDH, BDL, C4 */
+    uint8_t breakBaud[3];
+    dmx_stats_t stats;
+} dmx_port_t;
+
+static const dmx_port_config_t configs[2] = {
+    { UART1, kCLOCK_CoreSysClk, UART1_RX_TX_IRQn, (uint8_t)kDmaRequestMux0UART1Tx, PORTC, kCLOCK_PortC, 4U, kPORT_MuxAlt3 },
+    { UART4, kCLOCK_BusClk, UART4_RX_TX_IRQn, (uint8_t)kDmaRequestMux0UART4, PORTC, kCLOCK_PortC, 15U, kPORT_MuxAlt3 },
+};
+
+static dmx_port_t ports[DMX_PORTS];
+
+static void DMX_saveBaud(UART_Type *base, uint8_t *regs)
+{
+    regs[0] = base->BDH;
+    regs[1] = base->BDL;
+    regs[2] = base->C4;
+}
+
+/* Only called with the transmitter idle, BDL commits the divider */
+static void DMX_loadBaud(UART_Type *base, const uint8_t *regs)
+{
+    base->BDH = regs[0];
+    base->C4 = regs[2];
+    base->BDL = regs[1];
+}
+
+static void DMX_startBreak(dmx_port_t *p)
+{
+    UART_Type *base = p->config->base;
+
+    if (p->fresh && !p->writing) {
+        p->front ^= 1;
+        p->fresh = 0;
+    }
+
+    DMX_loadBaud(base, p->breakBaud);
+    p->state = kDMX_Break;
+
+    /* Reading S1 with TC set and then writing D clears TC */
+    (void)base->S1;
+    base->D = 0;
+    UART_EnableInterrupts(base, kUART_TransmissionCompleteInterruptEnable);
+}
+
+static void DMX_uartHandler(uint32_t n)
+{
+    dmx_port_t *p = &ports[n];
+    UART_Type *base = p->config->base;
+    dmachan_transfer_t transfer;
+
+    if (!(base->S1 & UART_S1_TC_MASK) || !(base->C2 & UART_C2_TCIE_MASK))
+        return;
+
+    if (p->state == kDMX_Break) {
+        UART_DisableInterrupts(base, kUART_TransmissionCompleteInterruptEnable);
+        DMX_loadBaud(base, p->dataBaud);
+
+        transfer.source = p->config->dmaSource;
+        transfer.src = p->buff[p->front];
+        transfer.srcOffset = 1;
+        transfer.srcSize = kDMACHAN_Size8;
+        transfer.dst = &base->D;
+        transfer.dstOffset = 0;
+        transfer.dstSize = kDMACHAN_Size8;
+        transfer.count = DMX_FRAME_SIZE;
+        transfer.interrupt = true;
+        DMACHAN_Start(DMX_DMA_CHANNEL + n, &transfer);
+
+        p->state = kDMX_Data;
+        UART_EnableTxDMA(base, true);
+    } else if (p->state == kDMX_Drain) {
+        p->stats.frames++;
+        DMX_startBreak(p);
+    }
+}
+
+static void DMX_dmaHandler(uint32_t n)
+{
+    dmx_port_t *p = &ports[n];
+
+    DMACHAN_ClearInterrupt(DMX_DMA_CHANNEL + n);
+    UART_EnableTxDMA(p->config->base, false);
+
+    p->state = kDMX_Drain;
+    UART_EnableInterrupts(p->config->base, kUART_TransmissionCompleteInterruptEnable);
+}
+
+void UART1_RX_TX_IRQHandler(void)
+{
+    DMX_uartHandler(0);
+}
+
+void DMA4_IRQHandler(void)
+{
+    DMX_dmaHandler(0);
+}
+
+#if DMX_PORTS > 1
+void UART4_RX_TX_IRQHandler(void)
+{
+    DMX_uartHandler(1);
+}
+
+void DMA5_IRQHandler(void)
+{
+    DMX_dmaHandler(1);
+}
+#endif
+
+void DMX_Init(void)
+{
+    uart_config_t config;
+    uint32_t clock;
+    uint32_t n;
+
+    DMACHAN_Init();
+
+    for (n = 0; n < DMX_PORTS; n++) {
+        dmx_port_t *p = &ports[n];
+        const dmx_port_config_t *c = &configs[n];
+
+        p->config = c;
+        CLOCK_EnableClock(c->portClock);
+        PORT_SetPinMux(c->port, c->pin, c->mux);
+
+        UART_GetDefaultConfig(&config);
+        config.baudRate_Bps = DMX_BREAK_BAUD;
+        config.stopBitCount = kUART_TwoStopBit;
+        config.enableTx = true;
+        config.enableRx = false;
+        clock = CLOCK_GetFreq(c->clock);
+
+        UART_Init(c->base, &config, clock);
+        DMX_saveBaud(c->base, p->breakBaud);
+        UART_SetBaudRate(c->base, DMX_BAUD, clock);
+        DMX_saveBaud(c->base, p->dataBaud);
+
+        EnableIRQ(c->irq);
+        DMX_startBreak(p);
+    }
+}
+
+void DMX_Update(e131_universe_t *u)
+{
+    dmx_port_t *p;
+    uint8_t *back;
+    uint16_t n;
+
+    n = E131_universeNumber(u) - DMX_UNIVERSE;
+    if (n >= DMX_PORTS)
+        return;
+    p = &ports[n];
+
+    /* The interrupt only swaps buffers while nobody is writing, so the back
+     * buffer can't become the one on the wire halfway through the copy */
+    p->writing = 1;
+    back = p->buff[p->front ^ 1];
+    memcpy(back, u->data, u->length);
+    if (u->length < DMX_FRAME_SIZE)
+        memset(back + u->length, 0, DMX_FRAME_SIZE - u->length);
+    p->fresh = 1;
+    p->writing = 0;
+
+    p->stats.updates++;
+}
+
+void DMX_GetStats(uint32_t port, dmx_stats_t *stats)
+{
+    *stats = ports[port].stats;
+}
+
+#endif /* DMX_PORTS > 0 */
@@ -0,0 +1,48 @@
+/*
+ * dmx_uart.h
+ *
+ *  DMX512 output on the UARTs.
+ *
+ *  Each port sends its universe continuously: a break and mark-after-break
+ *  made by the UART itself, then start code and 512 slots at 250 kbaud by
+ *  DMA.  The break is a 0x00 sent at DMX_BREAK_BAUD, whose start and data
+ *  bits hold the line low for 9 bit times and whose stop bits form the
+ *  MAB.  Everything after DMX_Init() runs from the UART and DMA interrupts;
+ *  DMX_Update() only copies slots into a back buffer that is picked up at
+ *  the next break.
+ */
+
+#ifndef DMX_UART_H_
+#define DMX_UART_H_
+
+#include "E131.h"
+
+#define DMX_BAUD 250000U
+#define DMX_BREAK_BAUD 83333U           /* 108 us break, 24 us MAB with two stop bits */
+#define DMX_FRAME_SIZE 513              /* Start code + 512 slots */
+
+#ifndef DMX_PORTS
+#define DMX_PORTS 2                     /* UART1 on PTC4, UART4 on PTC15, 0 to disable */
+#endif
+/* The last universes of the default range; the default pixel map stops before them */
+#ifndef DMX_UNIVERSE
+#define DMX_UNIVERSE (E131_DEFAULT_UNIVERSE + E131_DEFAULT_UNIVERSE_COUNT - DMX_PORTS)  /* Universe of port 0, the rest follow */
+#endif
+#ifndef DMX_DMA_CHANNEL
+#define DMX_DMA_CHANNEL 4U              /* Port n uses DMA channel DMX_DMA_CHANNEL + n */
+#endif
+
+typedef struct _dmx_stats
+{
+    uint32_t frames;                    /* Frames sent */
+    uint32_t updates;                   /* Universes copied in */
+} dmx_stats_t;
+
+void DMX_Init(void);
+
+/* e131_callback_t, sends the universe on the port mapped to it */
+void DMX_Update(e131_universe_t *u);
+
+void DMX_GetStats(uint32_t port, dmx_stats_t *stats);
+
+#endif /* DMX_UART_H_ */
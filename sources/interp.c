@@ -0,0 +1,108 @@
+/*
+ * interp.c
+ *
+ *  Linear blending between the previous and current frame of a universe.
+ *
+ *  Both paths compute, per channel, with the levels biased into signed
+ *  range (v ^ 0x8000 = v - 32768):
+ *
+ *      out = (prev * (ONE - w) + cur * w + ONE / 2) >> 15
+ *
+ *  Weights 0 and ONE are copies, so both factors fit a signed halfword and
+ *  the SIMD path can pair prev/cur of one channel against the two weights
+ *  in a single SMLAD.
+ */
+
+#include <string.h>
+
+#include "interp.h"
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include "fsl_device_registers.h"       /* CMSIS SIMD intrinsics */
+#define INTERP_SIMD 1
+#elif defined(INTERP_EMULATE_SIMD)
+/* The three instructions the SIMD path uses, for testing it on the host */
+static uint32_t __SMLAD(uint32_t x, uint32_t y, uint32_t acc)
+{
+    return (uint32_t)((int32_t)(int16_t)x * (int16_t)y + (int32_t)(int16_t)(x >> 16) * (int16_t)(y >> 16) +
+                      (int32_t)acc);
+}
+#define __PKHBT(a, b, sh) (((uint32_t)(a) & 0x0000FFFFU) | (((uint32_t)(b) << (sh)) & 0xFFFF0000U))
+#define __PKHTB(a, b, sh) (((uint32_t)(a) & 0xFFFF0000U) | ((uint32_t)((int32_t)(b) >> (sh)) & 0x0000FFFFU))
+#define INTERP_SIMD 1
+#else
+#define INTERP_SIMD 0
+#endif
+
+#define INTERP_BIAS 0x80008000U
+
+void INTERP_BlendRef(const uint16_t *prev, const uint16_t *cur, size_t n, uint32_t weight, uint16_t *dst)
+{
+    int32_t a, b, p, c;
+    size_t i;
+
+    if (weight == 0) {
+        memmove(dst, prev, n * sizeof(*dst));
+        return;
+    }
+    if (weight >= INTERP_ONE) {
+        memmove(dst, cur, n * sizeof(*dst));
+        return;
+    }
+
+    a = (int32_t)(INTERP_ONE - weight);
+    b = (int32_t)weight;
+    for (i = 0; i < n; i++) {
+        p = (int32_t)prev[i] - 32768;
+        c = (int32_t)cur[i] - 32768;
+        dst[i] = (uint16_t)(((p * a + c * b + (int32_t)(INTERP_ONE / 2)) >> 15) + 32768);
+    }
+}
+
+#if INTERP_SIMD
+void INTERP_Blend(const uint16_t *prev, const uint16_t *cur, size_t n, uint32_t weight, uint16_t *dst)
+{
+    uint32_t weights, p, c, r0, r1;
+    size_t i;
+
+    if (weight == 0 || weight >= INTERP_ONE || n < 2) {
+        INTERP_BlendRef(prev, cur, n, weight, dst);
+        return;
+    }
+
+    /* Bottom half weighs prev, top half cur */
+    weights = (weight << 16) | (INTERP_ONE - weight);
+
+    for (i = 0; i + 1 < n; i += 2) {
+        /* memcpy keeps word access legal for any alignment, it compiles to
+         * a plain LDR/STR on the M4 */
+        memcpy(&p, prev + i, sizeof(p));
+        memcpy(&c, cur + i, sizeof(c));
+        p ^= INTERP_BIAS;
+        c ^= INTERP_BIAS;
+
+        r0 = __SMLAD(__PKHBT(p, c, 16), weights, INTERP_ONE / 2);
+        r1 = __SMLAD(__PKHTB(c, p, 16), weights, INTERP_ONE / 2);
+        r0 = (uint32_t)((int32_t)r0 >> 15);
+        r1 = (uint32_t)((int32_t)r1 >> 15);
+
+        p = __PKHBT(r0, r1, 16) ^ INTERP_BIAS;
+        memcpy(dst + i, &p, sizeof(p));
+    }
+
+    if (i < n)
+        INTERP_BlendRef(prev + i, cur + i, 1, weight, dst + i);
+}
+#else
+void INTERP_Blend(const uint16_t *prev, const uint16_t *cur, size_t n, uint32_t weight, uint16_t *dst)
+{
+    INTERP_BlendRef(prev, cur, n, weight, dst);
+}
+#endif
+
+uint32_t INTERP_Weight(uint32_t elapsed, uint32_t interval, uint32_t limit)
+{
+    if (interval == 0 || interval > limit || elapsed >= interval)
+        return INTERP_ONE;
+    return (elapsed * INTERP_ONE) / interval;
+}
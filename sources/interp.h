@@ -0,0 +1,30 @@
+/*
+ * interp.h
+ *
+ *  Linear blending between the previous and current frame of a universe,
+ *  so outputs refreshing faster than sACN arrives fade smoothly instead of
+ *  stepping at the packet rate.
+ *
+ *  Levels are 16 bit.  On a Cortex-M4 two channels are blended per SMLAD;
+ *  elsewhere, and as the reference for the tests, in plain C.  Both give
+ *  bit-identical results.
+ */
+
+#ifndef INTERP_H_
+#define INTERP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define INTERP_ONE 32768U               /* Weight of a fully current frame */
+
+/* dst = prev + (cur - prev) * weight / INTERP_ONE, weight 0..INTERP_ONE */
+void INTERP_Blend(const uint16_t *prev, const uint16_t *cur, size_t n, uint32_t weight, uint16_t *dst);
+void INTERP_BlendRef(const uint16_t *prev, const uint16_t *cur, size_t n, uint32_t weight, uint16_t *dst);
+
+/* Weight for a refresh 'elapsed' ms after the current frame arrived, when
+ * frames arrive every 'interval' ms.  Intervals over 'limit' mean the
+ * sender paused or stopped, and the current frame is shown as is. */
+uint32_t INTERP_Weight(uint32_t elapsed, uint32_t interval, uint32_t limit);
+
+#endif /* INTERP_H_ */
@@ -0,0 +1,121 @@
+/*
+ * loss.c
+ *
+ *  What universes show once their sources are gone.
+ */
+
+#include <string.h>
+
+#include "loss.h"
+
+typedef struct _loss_entry
+{
+    uint16_t universe;
+    loss_policy_t policy;
+} loss_entry_t;
+
+static loss_entry_t entries[LOSS_MAX_POLICIES];
+static uint8_t count;
+static loss_policy_t fallback = { LOSS_DEFAULT_HOLD, LOSS_DEFAULT_FADE, NULL };
+
+int LOSS_SetPolicy(uint16_t universe, const loss_policy_t *policy)
+{
+    uint8_t i;
+
+    for (i = 0; i < count; i++) {
+        if (entries[i].universe == universe)
+            break;
+    }
+
+    if (!policy) {
+        if (i < count)
+            entries[i] = entries[--count];
+        return 0;
+    }
+
+    if (i == count) {
+        if (count == LOSS_MAX_POLICIES)
+            return -1;
+        count++;
+    }
+    entries[i].universe = universe;
+    entries[i].policy = *policy;
+    return 0;
+}
+
+void LOSS_SetDefault(const loss_policy_t *policy)
+{
+    fallback = *policy;
+}
+
+void LOSS_Fade(const uint8_t *from, const uint8_t *to, uint16_t n, uint32_t moved, uint32_t remaining,
+               uint8_t *dst)
+{
+    int32_t delta, half;
+    uint16_t i;
+
+    if (moved >= remaining) {
+        if (to)
+            memcpy(dst, to, n);
+        else
+            memset(dst, 0, n);
+        return;
+    }
+
+    /* 255 * 0x7FFFFF still fits an int32_t, fades over 2.3 h lose some resolution */
+    if (remaining > 0x7FFFFF) {
+        moved = (uint32_t)((uint64_t)moved * 0x7FFFFF / remaining);
+        remaining = 0x7FFFFF;
+    }
+
+    half = (int32_t)(remaining / 2);
+    for (i = 0; i < n; i++) {
+        delta = ((to ? to[i] : 0) - from[i]) * (int32_t)moved;
+        delta = delta >= 0 ? (delta + half) / (int32_t)remaining : -((-delta + half) / (int32_t)remaining);
+        dst[i] = (uint8_t)(from[i] + delta);
+    }
+}
+
+void LOSS_Update(e131_universe_t *u, uint32_t elapsed, uint32_t step)
+{
+    const loss_policy_t *policy = &fallback;
+    uint16_t number = E131_universeNumber(u);
+    uint32_t previous, start, end;
+    uint16_t length;
+    uint8_t i;
+
+    for (i = 0; i < count; i++) {
+        if (entries[i].universe == number) {
+            policy = &entries[i].policy;
+            break;
+        }
+    }
+
+    if (policy->hold == LOSS_FOREVER)
+        return;
+
+    /* Fade window and the part of it this step covers */
+    previous = elapsed - step;
+    start = policy->hold;
+    end = start + policy->fade;
+    if (end < start)
+        end = LOSS_FOREVER;
+    if (elapsed < start || (previous >= end && (step || elapsed > end)))
+        return;
+    if (previous < start)
+        previous = start;
+    if (elapsed > end)
+        elapsed = end;
+
+    /* The last look, as far as it goes, from levels only; a scene covers every slot */
+    length = u->data[0] == 0 ? u->length : 1;
+    if (policy->scene) {
+        if (length < E131_UNIVERSE_SIZE)
+            memset(u->data + length, 0, E131_UNIVERSE_SIZE - length);
+        length = E131_UNIVERSE_SIZE;
+    }
+
+    u->wbuff[0] = 0;
+    LOSS_Fade(u->data + 1, policy->scene, length - 1, elapsed - previous, end - previous, u->wbuff + 1);
+    E131_publish(u, length);
+}
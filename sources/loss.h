@@ -0,0 +1,55 @@
+/*
+ * loss.h
+ *
+ *  What universes show once their sources are gone.
+ *
+ *  A universe is lost when every source has been silent for the E1.31
+ *  timeout or has sent a stream terminated packet.  Its policy then holds
+ *  the last look for a while and fades from it to black or to a stored
+ *  scene; a fade of 0 cuts.  The looks are published as universe data, so
+ *  the pixel and DMX outputs follow without knowing about the loss, and
+ *  the first packet of a returning source takes over where the fade got.
+ *
+ *  Runs from E131_poll(), the one scheduler for every universe.
+ */
+
+#ifndef LOSS_H_
+#define LOSS_H_
+
+#include "E131.h"
+
+#define LOSS_FOREVER 0xFFFFFFFFU
+
+#ifndef LOSS_MAX_POLICIES
+#define LOSS_MAX_POLICIES 8             /* Universes with a policy of their own */
+#endif
+#ifndef LOSS_DEFAULT_HOLD
+#define LOSS_DEFAULT_HOLD LOSS_FOREVER  /* ms every other universe holds its last look */
+#endif
+#ifndef LOSS_DEFAULT_FADE
+#define LOSS_DEFAULT_FADE 0             /* ms every other universe then fades to black */
+#endif
+
+typedef struct _loss_policy
+{
+    uint32_t hold;                      /* ms to hold the last look, LOSS_FOREVER to keep it */
+    uint32_t fade;                      /* ms from the last look to the final one, 0 to cut */
+    const uint8_t *scene;               /* Final look, 512 slots, NULL for black */
+} loss_policy_t;
+
+/* Policy of one universe, NULL to fall back on the default.  Returns 0, or
+ * -1 if LOSS_MAX_POLICIES universes have one already. */
+int LOSS_SetPolicy(uint16_t universe, const loss_policy_t *policy);
+
+/* Policy of the universes without one */
+void LOSS_SetDefault(const loss_policy_t *policy);
+
+/* e131_loss_callback_t, register with E131_setLossCallback() */
+void LOSS_Update(e131_universe_t *u, uint32_t elapsed, uint32_t step);
+
+/* Move 'n' slots from 'from' towards 'to' by 'moved' of the 'remaining' ms
+ * left, rounded; moving all that remains lands on 'to'.  'to' NULL is black. */
+void LOSS_Fade(const uint8_t *from, const uint8_t *to, uint16_t n, uint32_t moved, uint32_t remaining,
+               uint8_t *dst);
+
+#endif /* LOSS_H_ */
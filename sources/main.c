@@ -39,7 +39,7 @@
 #include "lwip/tcpip.h"
 #include "netif/ethernet.h"
 #include "ethernetif.h"
-#include "fsl_ftm.h"
+#include "output.h"
 
 #include "board.h"
 
@@ -76,20 +76,6 @@
 #define configPHY_ADDRESS 1
 
 
-/* The Flextimer instance/channel used for board */
-#define BOARD_FTM_BASEADDR FTM0
-#define BOARD_FTM_CHANNEL kFTM_Chnl_0
-
-/* Interrupt number and interrupt handler for the FTM instance used */
-#define FTM_INTERRUPT_NUMBER FTM0_IRQn
-#define FTM_LED_HANDLER FTM0_IRQHandler
-
-/* Interrupt to enable and flag to read; depends on the FTM channel used */
-#define FTM_CHANNEL_INTERRUPT_ENABLE kFTM_Chnl0InterruptEnable
-#define FTM_CHANNEL_FLAG kFTM_Chnl0Flag
-
-/* Get source clock for FTM driver */
-#define FTM_SOURCE_CLOCK CLOCK_GetFreq(kCLOCK_BusClk)
 
 /*******************************************************************************
 * Prototypes
@@ -98,45 +84,11 @@
 /*******************************************************************************
 * Variables
 ******************************************************************************/
-volatile bool ftmIsrFlag = false;
-volatile bool brightnessUp = true; /* Indicate LED is brighter or dimmer */
-volatile uint8_t updatedDutycycle = 10U;
 /*******************************************************************************
  * Code
  ******************************************************************************/
 
 
-void FTM_LED_HANDLER(void)
-{
-    ftmIsrFlag = true;
-
-    if (brightnessUp)
-    {
-        /* Increase duty cycle until it reach limited value, don't want to go upto 100% duty cycle
-         * as channel interrupt will not be set for 100%
-         */
-        if (++updatedDutycycle >= 99U)
-        {
-            updatedDutycycle = 99U;
-            brightnessUp = false;
-        }
-    }
-    else
-    {
-        /* Decrease duty cycle until it reach limited value */
-        if (--updatedDutycycle == 1U)
-        {
-            brightnessUp = true;
-        }
-    }
-
-    if ((FTM_GetStatusFlags(BOARD_FTM_BASEADDR) & FTM_CHANNEL_FLAG) == FTM_CHANNEL_FLAG)
-    {
-        /* Clear interrupt flag.*/
-        FTM_ClearStatusFlags(BOARD_FTM_BASEADDR, FTM_CHANNEL_FLAG);
-    }
-}
-
 
 /*!
  * @brief Main function
@@ -145,9 +97,6 @@ int main(void)
 {
     static struct netif fsl_netif0;
     ip4_addr_t fsl_netif0_ipaddr, fsl_netif0_netmask, fsl_netif0_gw;
-    ftm_config_t ftmInfo;
-    ftm_chnl_pwm_signal_param_t ftmParam;
-    ftm_pwm_level_select_t pwmLevel = kFTM_LowTrue;
 
 
     MPU_Type *base = MPU;
@@ -160,29 +109,8 @@ int main(void)
 
 
 
-    /* Configure ftm params with frequency 24kHZ */
-    ftmParam.chnlNumber = BOARD_FTM_CHANNEL;
-	ftmParam.level = pwmLevel;
-	ftmParam.dutyCyclePercent = updatedDutycycle;
-	ftmParam.firstEdgeDelayPercent = 0U;
-
-	FTM_GetDefaultConfig(&ftmInfo);
-	/* Initialize FTM module */
-	FTM_Init(BOARD_FTM_BASEADDR, &ftmInfo);
-
-	FTM_SetupPwm(BOARD_FTM_BASEADDR, &ftmParam, 1U, kFTM_CenterAlignedPwm, 24000U, FTM_SOURCE_CLOCK);
-
-	/* Enable channel interrupt flag.*/
-	FTM_EnableInterrupts(BOARD_FTM_BASEADDR, FTM_CHANNEL_INTERRUPT_ENABLE);
-
-	/* Enable at the NVIC */
-	EnableIRQ(FTM_INTERRUPT_NUMBER);
-
-	FTM_StartTimer(BOARD_FTM_BASEADDR, kFTM_SystemClock);
-
-
-
-
+    /* Pixel output, blanks the strip */
+    OUTPUT_Init();
 
     IP4_ADDR(&fsl_netif0_ipaddr, configIP_ADDR0, configIP_ADDR1, configIP_ADDR2, configIP_ADDR3);
     IP4_ADDR(&fsl_netif0_netmask, configNET_MASK0, configNET_MASK1, configNET_MASK2, configNET_MASK3);
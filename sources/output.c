@@ -0,0 +1,333 @@
+/*
+ * output.c
+ *
+ *  Routes received universes to the pixel and DMX outputs.
+ */
+
+#include <string.h>
+
+#include "output.h"
+#include "dmx_uart.h"
+#include "fsl_debug_console.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define OUTPUT_STRIDE (OUTPUT_PIXELS * OUTPUT_PIXEL_CHANNELS)  /* Channels per strand */
+#define OUTPUT_CHANNELS (OUTPUT_STRANDS * OUTPUT_STRIDE)
+
+/* Corrected levels in wire order, strand after strand.  Written by
+ * OUTPUT_Update() and read by the refresh task without a lock: a refresh
+ * may catch a universe half copied, which the next one, a few ms later,
+ * puts right. */
+static uint16_t levels[OUTPUT_CHANNELS];
+#if OUTPUT_INTERPOLATE
+/* With interpolation each strand rotates through three frames: the
+ * previous and the current one, which 'levels' blends between, and the
+ * next, which received levels go to.  The rotation happens when the last
+ * universe a strand maps arrives, and the frame that drops out becomes the
+ * next one. */
+static uint16_t frames[3][OUTPUT_CHANNELS];
+static uint8_t previous[OUTPUT_STRANDS];                       /* Frame blended from */
+static uint8_t current[OUTPUT_STRANDS];                        /* Frame holding the newest levels */
+static uint32_t arrival[OUTPUT_STRANDS];                       /* E131_now() of the newest levels */
+static uint32_t interval[OUTPUT_STRANDS];                      /* ms between the last two frames */
+#endif
+#if OUTPUT_DITHER && OUTPUT_MODE != OUTPUT_CLOCKED
+static uint8_t residual[OUTPUT_CHANNELS];                      /* Carried fractions */
+#endif
+static color_lut16_t luts[OUTPUT_STRANDS];                     /* Gamma and white balance per strand */
+static const color_lut16_t *lutp[OUTPUT_STRANDS];
+static uint16_t *targets[OUTPUT_STRANDS];                      /* Where each strand's universes land */
+static map_output_t map[OUTPUT_STRANDS];
+static map_plan_t plan;
+static uint16_t used[OUTPUT_STRANDS];                          /* Channels mapped on each strand */
+static power_budget_t budgets[OUTPUT_STRANDS];
+static power_stats_t power[OUTPUT_STRANDS];                    /* Written by the refresh task only */
+
+#if OUTPUT_MODE == OUTPUT_CLOCKED
+/* APA102 pixels are encoded straight from the 16 bit levels: the per pixel
+ * current header carries the range 8 bits lack, in place of dithering */
+static uint8_t frame[APA102_FRAME_BYTES(OUTPUT_PIXELS)];       /* Complete APA102 frame */
+#else
+static uint8_t frame[OUTPUT_CHANNELS];                         /* Wire order (GRB), strand after strand */
+#endif
+
+#if OUTPUT_INTERPOLATE
+static void OUTPUT_blend(void)
+{
+    uint32_t now = E131_now();
+    uint32_t weight;
+    uint16_t offset;
+    uint8_t strand;
+
+    for (strand = 0; strand < plan.outputs; strand++) {
+        offset = strand * OUTPUT_STRIDE;
+        weight = INTERP_Weight(now - arrival[strand], interval[strand], OUTPUT_INTERP_LIMIT);
+        INTERP_Blend(frames[previous[strand]] + offset, frames[current[strand]] + offset, used[strand], weight,
+                     levels + offset);
+    }
+}
+#endif
+
+static bool OUTPUT_busy(void)
+{
+#if OUTPUT_MODE == OUTPUT_PARALLEL
+    return WS2812PORT_IsBusy();
+#elif OUTPUT_MODE == OUTPUT_CLOCKED
+    return APA102_IsBusy();
+#else
+    return WS2812_IsBusy();
+#endif
+}
+
+static void OUTPUT_refresh(void)
+{
+    uint32_t scale;
+    uint16_t offset;
+    uint16_t bytes;
+    uint8_t strand;
+
+#if OUTPUT_INTERPOLATE
+    OUTPUT_blend();
+#endif
+
+    /* Strands are as long as their map; the parallel port clocks out the
+     * longest, the rest padded with the dark levels OUTPUT_SetMap() left.
+     * Strands past plan.outputs are not dithered at all and go out as the
+     * dark bytes OUTPUT_SetMap() wrote when it dropped them. */
+#if OUTPUT_MODE == OUTPUT_PARALLEL
+    bytes = 0;
+    for (strand = 0; strand < plan.outputs; strand++) {
+        if (used[strand] > bytes)
+            bytes = used[strand];
+    }
+#endif
+
+    for (strand = 0; strand < plan.outputs; strand++) {
+        offset = strand * OUTPUT_STRIDE;
+#if OUTPUT_MODE != OUTPUT_PARALLEL
+        bytes = used[strand];
+#endif
+        scale = POWER_Limit(levels + offset, map[strand].pixels, MAP_ORDER_CHANNELS(map[strand].order),
+                            &budgets[strand], &power[strand]);
+#if OUTPUT_MODE == OUTPUT_CLOCKED
+        APA102_Encode16(levels + offset, bytes / 3, OUTPUT_BRIGHTNESS, scale, frame);
+#elif OUTPUT_DITHER
+        DITHER_Apply(levels + offset, residual + offset, bytes, scale, frame + offset);
+#else
+        DITHER_Round(levels + offset, bytes, scale, frame + offset);
+#endif
+    }
+
+#if OUTPUT_MODE == OUTPUT_PARALLEL
+    WS2812PORT_Show(frame, OUTPUT_STRIDE, bytes);
+#elif OUTPUT_MODE == OUTPUT_CLOCKED
+    APA102_Show(frame, APA102_FRAME_BYTES(used[0] / 3));
+#else
+    WS2812_Show(frame, used[0]);
+#endif
+}
+
+static void OUTPUT_task(void *arg)
+{
+    TickType_t wake;
+
+    (void)arg;
+
+    wake = xTaskGetTickCount();
+    for (;;) {
+        vTaskDelayUntil(&wake, configTICK_RATE_HZ / OUTPUT_REFRESH_HZ);
+
+        /* A frame still going out means the rate is set too high for the
+         * strand; skip rather than let the dither run ahead of the pixels */
+        if (!OUTPUT_busy())
+            OUTPUT_refresh();
+    }
+}
+
+void OUTPUT_SetCorrection(uint8_t strand, const color_correction_t *cc)
+{
+    if (strand < OUTPUT_STRANDS)
+        COLORLUT_Build16(&luts[strand], cc);
+}
+
+void OUTPUT_SetPowerBudget(uint8_t strand, const power_budget_t *budget)
+{
+    if (strand < OUTPUT_STRANDS)
+        budgets[strand] = *budget;
+}
+
+void OUTPUT_GetPowerStats(uint8_t strand, power_stats_t *stats)
+{
+    if (strand < OUTPUT_STRANDS)
+        *stats = power[strand];
+}
+
+int OUTPUT_SetMap(const map_output_t *outputs, uint8_t count)
+{
+    map_output_t m[OUTPUT_STRANDS];
+    uint16_t offset;
+    uint8_t strand;
+
+    if (count > OUTPUT_STRANDS)
+        return -1;
+
+    memset(m, 0, sizeof(m));
+    for (strand = 0; strand < count; strand++) {
+        m[strand] = outputs[strand];
+        m[strand].base = strand * OUTPUT_STRIDE;
+        if (m[strand].pixels * MAP_ORDER_CHANNELS(m[strand].order) > OUTPUT_STRIDE)
+            return -1;
+#if OUTPUT_MODE == OUTPUT_CLOCKED
+        if (MAP_ORDER_CHANNELS(m[strand].order) != 3)
+            return -1;
+#endif
+    }
+
+    /* Compile into the live plan only once the outputs are known to fit */
+    if (MAP_Compile(&plan, m, count)) {
+        MAP_Compile(&plan, map, OUTPUT_STRANDS);
+        return -1;
+    }
+
+    for (strand = 0; strand < OUTPUT_STRANDS; strand++) {
+        if (strand < count) {
+            map[strand] = m[strand];
+            used[strand] = m[strand].pixels * MAP_ORDER_CHANNELS(m[strand].order);
+        } else {
+            map[strand].pixels = 0;
+            used[strand] = 0;
+        }
+
+        /* Pixels no longer mapped go dark, down to the bytes on the wire:
+         * the refresh task no longer writes those of dropped strands.  An
+         * APA102 frame ends with the map instead. */
+        offset = strand * OUTPUT_STRIDE + used[strand];
+        memset(levels + offset, 0, (OUTPUT_STRIDE - used[strand]) * sizeof(uint16_t));
+#if OUTPUT_MODE != OUTPUT_CLOCKED
+        memset(frame + offset, 0, OUTPUT_STRIDE - used[strand]);
+#if OUTPUT_DITHER
+        memset(residual + offset, 0, OUTPUT_STRIDE - used[strand]);
+#endif
+#endif
+#if OUTPUT_INTERPOLATE
+        memset(frames[0] + offset, 0, (OUTPUT_STRIDE - used[strand]) * sizeof(uint16_t));
+        memset(frames[1] + offset, 0, (OUTPUT_STRIDE - used[strand]) * sizeof(uint16_t));
+        memset(frames[2] + offset, 0, (OUTPUT_STRIDE - used[strand]) * sizeof(uint16_t));
+#endif
+    }
+    return 0;
+}
+
+void OUTPUT_Init(void)
+{
+    color_correction_t cc = { OUTPUT_GAMMA, OUTPUT_WHITE };
+    power_budget_t budget;
+    map_output_t m[OUTPUT_STRANDS];
+    uint32_t first, room;
+    uint8_t strand;
+
+    /* APA102 current follows the global brightness as well */
+#if OUTPUT_MODE == OUTPUT_CLOCKED
+    budget.mA[0] = OUTPUT_POWER_CHANNEL_MA * OUTPUT_BRIGHTNESS / APA102_BRIGHTNESS_MAX;
+#else
+    budget.mA[0] = OUTPUT_POWER_CHANNEL_MA;
+#endif
+    budget.mA[1] = budget.mA[0];
+    budget.mA[2] = budget.mA[0];
+    budget.mA[3] = budget.mA[0];
+    budget.idle = OUTPUT_POWER_IDLE_UA;
+    budget.budget = OUTPUT_POWER_BUDGET;
+
+    for (strand = 0; strand < OUTPUT_STRANDS; strand++) {
+        OUTPUT_SetCorrection(strand, &cc);
+        OUTPUT_SetPowerBudget(strand, &budget);
+        POWER_ResetStats(&power[strand]);
+        lutp[strand] = &luts[strand];
+#if OUTPUT_INTERPOLATE
+        previous[strand] = 0;
+        current[strand] = 1;
+        targets[strand] = frames[2];
+#else
+        targets[strand] = levels;
+#endif
+
+        /* Strands past the end of the universe range stay dark, the one
+         * reaching it is cut short */
+        first = OUTPUT_UNIVERSE + strand * OUTPUT_STRAND_UNIVERSES;
+        room = first < OUTPUT_UNIVERSE + OUTPUT_UNIVERSE_COUNT ?
+               (OUTPUT_UNIVERSE + OUTPUT_UNIVERSE_COUNT - first) * OUTPUT_PIXELS_PER_UNIVERSE : 0;
+        m[strand].universe = (uint16_t)first;
+        m[strand].channel = 1;
+        m[strand].pixels = (uint16_t)(room < OUTPUT_PIXELS ? room : OUTPUT_PIXELS);
+        m[strand].universePixels = OUTPUT_PIXELS_PER_UNIVERSE;
+        m[strand].zigzag = 0;
+        m[strand].order = OUTPUT_ORDER;
+        m[strand].reverse = 0;
+    }
+    OUTPUT_SetMap(m, OUTPUT_STRANDS);
+
+#if OUTPUT_MODE == OUTPUT_PARALLEL
+    WS2812PORT_Init(OUTPUT_TYPE);
+#elif OUTPUT_MODE == OUTPUT_CLOCKED
+    APA102_Init();
+#else
+    WS2812_Init(OUTPUT_TYPE);
+#endif
+    OUTPUT_refresh();
+
+    if (xTaskCreate(OUTPUT_task, "output", OUTPUT_TASK_STACKSIZE, NULL, OUTPUT_TASK_PRIORITY, NULL) != pdPASS)
+        PRINTF("output: task creation failed\r\n");
+
+#if DMX_PORTS
+    DMX_Init();
+#endif
+}
+
+void OUTPUT_Update(e131_universe_t *u)
+{
+    uint16_t number;
+#if OUTPUT_INTERPOLATE
+    uint32_t now;
+    uint16_t offset;
+    uint8_t strand;
+    uint8_t next;
+#endif
+
+#if DMX_PORTS
+    DMX_Update(u);
+#endif
+
+    if (u->data[0] != 0)
+        return;
+
+    /* Slots past the end of a short packet keep their last value */
+    number = E131_universeNumber(u);
+    MAP_Apply(&plan, number, u->data + 1, u->length - 1, lutp, targets);
+
+#if OUTPUT_INTERPOLATE
+    /* A strand's new frame is complete with its last universe; it becomes
+     * the current one, the current one the previous, and the old previous
+     * frame is the next, starting as a copy of the new frame so universes
+     * that skip a frame keep their levels.  The refresh task preempts this,
+     * so the indexes and times change together in a critical section and
+     * the copy goes to a frame it no longer reads. */
+    now = E131_now();
+    for (strand = 0; strand < OUTPUT_STRANDS; strand++) {
+        if (used[strand] == 0 || plan.lastUniverse[strand] != number)
+            continue;
+        taskENTER_CRITICAL();
+        next = previous[strand];
+        previous[strand] = current[strand];
+        current[strand] = (uint8_t)(3 - next - previous[strand]);
+        interval[strand] = now - arrival[strand];
+        arrival[strand] = now;
+        taskEXIT_CRITICAL();
+
+        offset = strand * OUTPUT_STRIDE;
+        memcpy(frames[next] + offset, frames[current[strand]] + offset, used[strand] * sizeof(uint16_t));
+        targets[strand] = frames[next];
+    }
+#endif
+}
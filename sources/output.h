@@ -0,0 +1,162 @@
+/*
+ * output.h
+ *
+ *  Routes received universes to the pixel and DMX outputs.
+ *
+ *  By default each strand holds OUTPUT_PIXELS pixels at 170 per universe
+ *  (128 for RGBW).  Strand 0 starts at OUTPUT_UNIVERSE and every further
+ *  strand starts on the universe after the previous one ends, up to the
+ *  end of the default E1.31 range, or to the DMX universes at its end with
+ *  DMX_PORTS: strands beyond that are left unmapped, so no universe drives
+ *  both pixels and DMX.
+ *  OUTPUT_SetMap() replaces that with any layout pixel_map.h describes.
+ *  The E1.31 universe range has to cover every universe mapped.
+ *
+ *  Received levels go through the strand's color table into a 16 bit frame.
+ *  A task refreshes the pixels from that frame at OUTPUT_REFRESH_HZ, faster
+ *  than sACN arrives and independent of it, and temporal dithering spreads
+ *  the bits the pixels can't show across refreshes; APA102 pixels take the
+ *  16 bit levels instead, their per pixel current making up the range.  With OUTPUT_INTERPOLATE
+ *  each strand keeps its previous frame as well and refreshes blend from
+ *  it to the current one over the time the sender takes between frames,
+ *  while a third frame takes the next one in; this costs one frame of
+ *  latency.  Each refresh estimates the current
+ *  every strand will draw and scales strands over their budget down.
+ */
+
+#ifndef OUTPUT_H_
+#define OUTPUT_H_
+
+#include "E131.h"
+#include "dmx_uart.h"
+#include "ws2812.h"
+#include "apa102.h"
+#include "color_lut.h"
+#include "dither.h"
+#include "interp.h"
+#include "pixel_map.h"
+#include "power.h"
+
+/* Output modes */
+#define OUTPUT_SERIAL 0                        /* One strand on the FTM PWM pin */
+#define OUTPUT_PARALLEL 1                      /* WS2812PORT_STRANDS strands on a GPIO port */
+#define OUTPUT_CLOCKED 2                       /* One APA102/SK9822 strand on SPI */
+
+#ifndef OUTPUT_MODE
+#define OUTPUT_MODE OUTPUT_SERIAL
+#endif
+#ifndef OUTPUT_UNIVERSE
+#define OUTPUT_UNIVERSE E131_DEFAULT_UNIVERSE  /* Universe holding the first pixel */
+#endif
+#ifndef OUTPUT_UNIVERSE_COUNT
+#if DMX_PORTS
+#define OUTPUT_UNIVERSE_COUNT (DMX_UNIVERSE - OUTPUT_UNIVERSE)  /* Universes the default map spans, up to the DMX ones */
+#else
+#define OUTPUT_UNIVERSE_COUNT (E131_DEFAULT_UNIVERSE + E131_DEFAULT_UNIVERSE_COUNT - OUTPUT_UNIVERSE)
+#endif
+#endif
+/* Universes from OUTPUT_UNIVERSE the default outputs take, pixels then DMX;
+ * the firmware listens to this range */
+#define OUTPUT_RANGE_UNIVERSES (OUTPUT_UNIVERSE_COUNT + DMX_PORTS)
+#ifndef OUTPUT_TYPE
+#define OUTPUT_TYPE kWS2812_TypeWS2812
+#endif
+#ifndef OUTPUT_ORDER
+#if OUTPUT_MODE == OUTPUT_CLOCKED
+#define OUTPUT_ORDER MAP_ORDER_RGB             /* Color order of the default map */
+#else
+#define OUTPUT_ORDER MAP_ORDER_GRB
+#endif
+#endif
+#define OUTPUT_PIXEL_CHANNELS MAP_ORDER_CHANNELS(OUTPUT_ORDER)
+
+#ifndef OUTPUT_GAMMA
+#define OUTPUT_GAMMA 2.2f                      /* Default correction of every strand */
+#endif
+#ifndef OUTPUT_WHITE
+#define OUTPUT_WHITE { 255, 255, 255, 255 }    /* Default white point, red, green, blue, white */
+#endif
+#ifndef OUTPUT_DITHER
+#define OUTPUT_DITHER 1                        /* 0 rounds the 16 bit levels instead, APA102 never dithers */
+#endif
+#ifndef OUTPUT_INTERPOLATE
+#define OUTPUT_INTERPOLATE 0                   /* Blend between frames at the refresh rate */
+#endif
+#ifndef OUTPUT_INTERP_LIMIT
+#define OUTPUT_INTERP_LIMIT 100                /* ms between frames beyond which frames are shown as is */
+#endif
+#ifndef OUTPUT_POWER_BUDGET
+#define OUTPUT_POWER_BUDGET 0                  /* mA per strand, 0 for no limit */
+#endif
+#ifndef OUTPUT_POWER_CHANNEL_MA
+#define OUTPUT_POWER_CHANNEL_MA 20             /* mA of one LED at full level */
+#endif
+#ifndef OUTPUT_POWER_IDLE_UA
+#define OUTPUT_POWER_IDLE_UA 1000              /* Quiescent uA per pixel */
+#endif
+#ifndef OUTPUT_TASK_PRIORITY
+#define OUTPUT_TASK_PRIORITY 10                /* Above the network, refreshes are short */
+#endif
+#ifndef OUTPUT_TASK_STACKSIZE
+#define OUTPUT_TASK_STACKSIZE 256
+#endif
+#ifndef OUTPUT_BRIGHTNESS
+#define OUTPUT_BRIGHTNESS APA102_BRIGHTNESS_MAX  /* Global APA102 brightness, 0..31 */
+#endif
+
+#if OUTPUT_MODE == OUTPUT_PARALLEL
+#define OUTPUT_STRANDS WS2812PORT_STRANDS
+#ifndef OUTPUT_PIXELS
+#define OUTPUT_PIXELS (WS2812PORT_MAX_PIXELS * WS2812_BYTES_PER_PIXEL / OUTPUT_PIXEL_CHANNELS)  /* Per strand */
+#endif
+#ifndef OUTPUT_REFRESH_HZ
+#define OUTPUT_REFRESH_HZ 84                   /* 340 pixels take 10.5 ms */
+#endif
+#elif OUTPUT_MODE == OUTPUT_CLOCKED
+#define OUTPUT_STRANDS 1
+#if OUTPUT_PIXEL_CHANNELS != 3
+#error "APA102 pixels are RGB"
+#endif
+#ifndef OUTPUT_PIXELS
+#define OUTPUT_PIXELS APA102_MAX_PIXELS        /* Pixels per strand */
+#endif
+#ifndef OUTPUT_REFRESH_HZ
+#define OUTPUT_REFRESH_HZ 250                  /* 510 pixels take 2.1 ms at 8 MHz */
+#endif
+#else
+#define OUTPUT_STRANDS 1
+#ifndef OUTPUT_PIXELS
+#define OUTPUT_PIXELS (WS2812_MAX_PIXELS * WS2812_BYTES_PER_PIXEL / OUTPUT_PIXEL_CHANNELS)  /* Per strand */
+#endif
+#ifndef OUTPUT_REFRESH_HZ
+#define OUTPUT_REFRESH_HZ 84
+#endif
+#endif
+
+#define OUTPUT_PIXELS_PER_UNIVERSE (MAP_SLOTS / OUTPUT_PIXEL_CHANNELS)  /* Default map, 510 of the 512 slots for RGB */
+#define OUTPUT_STRAND_UNIVERSES ((OUTPUT_PIXELS + OUTPUT_PIXELS_PER_UNIVERSE - 1) / OUTPUT_PIXELS_PER_UNIVERSE)
+#define OUTPUT_UNIVERSES (OUTPUT_STRAND_UNIVERSES * OUTPUT_STRANDS)
+
+/* Set up the outputs and create the refresh task, before the scheduler starts */
+void OUTPUT_Init(void);
+
+/* Rebuild the color tables of one strand.  Call from the receiving context,
+ * the tables are read while universes are encoded. */
+void OUTPUT_SetCorrection(uint8_t strand, const color_correction_t *cc);
+
+/* Current per channel, in wire order, and the budget of one strand */
+void OUTPUT_SetPowerBudget(uint8_t strand, const power_budget_t *budget);
+
+/* How often and how far a strand has been limited */
+void OUTPUT_GetPowerStats(uint8_t strand, power_stats_t *stats);
+
+/* Map universes to strands, output n driving strand n.  The base of each
+ * output is filled in; outputs MAP_Compile() rejects, outputs with more
+ * channels than a strand holds, or RGBW on APA102, are rejected.  Returns
+ * 0, or -1 leaving the map as it was.  Call from the receiving context, like OUTPUT_SetCorrection(). */
+int OUTPUT_SetMap(const map_output_t *outputs, uint8_t count);
+
+/* e131_callback_t, register with E131_setCallback() */
+void OUTPUT_Update(e131_universe_t *u);
+
+#endif /* OUTPUT_H_ */
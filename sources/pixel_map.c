@@ -0,0 +1,264 @@
+/*
+ * pixel_map.c
+ *
+ *  Mapping from DMX slots to pixel outputs.
+ */
+
+#include "pixel_map.h"
+
+/* Source channel feeding each wire channel */
+static const uint8_t shuffles[8][4] = {
+    { 0, 1, 2, 0 },     /* RGB */
+    { 0, 2, 1, 0 },     /* RBG */
+    { 1, 0, 2, 0 },     /* GRB */
+    { 1, 2, 0, 0 },     /* GBR */
+    { 2, 0, 1, 0 },     /* BRG */
+    { 2, 1, 0, 0 },     /* BGR */
+    { 0, 1, 2, 3 },     /* RGBW */
+    { 1, 0, 2, 3 },     /* GRBW */
+};
+
+uint16_t MAP_Position(const map_output_t *output, uint16_t p)
+{
+    uint16_t run, pos, len;
+
+    if (output->zigzag) {
+        run = p / output->zigzag;
+        pos = p % output->zigzag;
+        if (run & 1) {
+            /* A short last run folds back over its own length */
+            len = output->pixels - run * output->zigzag;
+            if (len > output->zigzag)
+                len = output->zigzag;
+            p = run * output->zigzag + (len - 1 - pos);
+        }
+    }
+    if (output->reverse)
+        p = output->pixels - 1 - p;
+    return p;
+}
+
+/* Add one pixel, or the part of it in one universe, extending the last run if it fits */
+static int MAP_add(map_plan_t *plan, const map_op_t *frag, uint16_t universe, uint16_t *universes)
+{
+    map_op_t *prev;
+
+    if (plan->ops) {
+        prev = &plan->op[plan->ops - 1];
+        if (universes[plan->ops - 1] == universe && prev->output == frag->output && prev->first == 0 &&
+            prev->last == prev->channels && frag->first == 0 && frag->last == frag->channels &&
+            frag->slot == prev->slot + prev->count * prev->channels) {
+            if (prev->count == 1 && (frag->dst == prev->dst + prev->channels || frag->dst == prev->dst - prev->channels)) {
+                prev->step = (int16_t)(frag->dst - prev->dst);
+                prev->count++;
+                return 0;
+            }
+            if (prev->count > 1 && frag->dst == prev->dst + prev->count * prev->step) {
+                prev->count++;
+                return 0;
+            }
+        }
+    }
+
+    if (plan->ops == MAP_MAX_OPS)
+        return -1;
+    universes[plan->ops] = universe;
+    plan->op[plan->ops++] = *frag;
+    return 0;
+}
+
+/* Rejects what would index outside a universe, the level array or the order tables */
+static int MAP_valid(const map_output_t *o)
+{
+    uint8_t channels = MAP_ORDER_CHANNELS(o->order);
+    uint32_t last;
+
+    if (o->pixels == 0)
+        return 1;
+    if (o->universe == 0 || o->channel == 0 || o->channel > MAP_SLOTS || o->order > MAP_ORDER_GRBW)
+        return 0;
+    if (o->universePixels && o->channel - 1U + (uint32_t)o->universePixels * channels > MAP_SLOTS)
+        return 0;
+    if (o->zigzag > o->pixels)
+        return 0;
+    if (o->base + (uint32_t)o->pixels * channels > 0xFFFFU)
+        return 0;
+
+    /* Global slot of the last channel, as MAP_Compile() counts it */
+    last = o->channel - 1U;
+    if (o->universePixels)
+        last += (uint32_t)((o->pixels - 1U) / o->universePixels) * MAP_SLOTS +
+                (uint32_t)((o->pixels - 1U) % o->universePixels) * channels;
+    else
+        last += (uint32_t)(o->pixels - 1U) * channels;
+    last += channels - 1U;
+    return o->universe + last / MAP_SLOTS <= MAP_UNIVERSE_MAX;
+}
+
+int MAP_Compile(map_plan_t *plan, const map_output_t *outputs, uint8_t count)
+{
+    static uint16_t universes[MAP_MAX_OPS];     /* Universe of each operation while compiling */
+    const map_output_t *o;
+    map_op_t frag, t;
+    uint32_t g, slot, room;
+    uint16_t u, lo, hi, tu;
+    uint16_t p, i, j;
+    uint8_t n, k, channels;
+
+    if (count > MAP_MAX_OUTPUTS)
+        return -1;
+
+    plan->ops = 0;
+    plan->outputs = count;
+    lo = 0xFFFF;
+    hi = 0;
+
+    for (n = 0; n < count; n++) {
+        if (!MAP_valid(&outputs[n]))
+            return -1;
+    }
+
+    for (n = 0; n < count; n++) {
+        o = &outputs[n];
+        channels = MAP_ORDER_CHANNELS(o->order);
+        plan->lastUniverse[n] = o->universe;
+
+        frag.output = n;
+        frag.channels = channels;
+        frag.step = (int16_t)channels;
+        frag.count = 1;
+        for (k = 0; k < 4; k++)
+            frag.shuffle[k] = shuffles[o->order][k];
+
+        for (p = 0; p < o->pixels; p++) {
+            /* Global slot of the pixel's first channel, counting 512 per universe */
+            g = o->channel - 1U;
+            if (o->universePixels)
+                g += (uint32_t)(p / o->universePixels) * MAP_SLOTS + (uint32_t)(p % o->universePixels) * channels;
+            else
+                g += (uint32_t)p * channels;
+
+            frag.dst = (uint16_t)(o->base + MAP_Position(o, p) * channels);
+
+            /* Split where the pixel crosses into the next universe */
+            for (k = 0; k < channels; k = frag.last) {
+                u = (uint16_t)(o->universe + (g + k) / MAP_SLOTS);
+                slot = (g + k) % MAP_SLOTS;
+                frag.slot = (uint16_t)slot;
+                frag.first = k;
+                room = MAP_SLOTS - slot;
+                frag.last = (uint8_t)(room < (uint32_t)(channels - k) ? k + room : channels);
+                if (MAP_add(plan, &frag, u, universes))
+                    return -1;
+                if (u < lo)
+                    lo = u;
+                if (u > hi)
+                    hi = u;
+                if (u > plan->lastUniverse[n])
+                    plan->lastUniverse[n] = u;
+            }
+        }
+    }
+
+    if (plan->ops == 0) {
+        plan->universe = 0;
+        plan->universes = 0;
+        plan->opStart[0] = 0;
+        return 0;
+    }
+    if (hi - lo + 1 > MAP_MAX_UNIVERSES)
+        return -1;
+    plan->universe = lo;
+    plan->universes = hi - lo + 1;
+
+    /* Stable insertion sort by universe; runs of one output are already in order */
+    for (i = 1; i < plan->ops; i++) {
+        t = plan->op[i];
+        tu = universes[i];
+        for (j = i; j > 0 && universes[j - 1] > tu; j--) {
+            plan->op[j] = plan->op[j - 1];
+            universes[j] = universes[j - 1];
+        }
+        plan->op[j] = t;
+        universes[j] = tu;
+    }
+
+    for (i = 0, u = 0; u <= plan->universes; u++) {
+        while (i < plan->ops && universes[i] < lo + u)
+            i++;
+        plan->opStart[u] = i;
+    }
+
+    return 0;
+}
+
+void MAP_Apply(const map_plan_t *plan, uint16_t universe, const uint8_t *slots, uint16_t count,
+               const color_lut16_t *const *luts, uint16_t *const *levels)
+{
+    const map_op_t *op, *end;
+    const uint16_t *tab[4];
+    const uint16_t *t0, *t1, *t2, *t3;
+    const uint8_t *s;
+    uint16_t *d;
+    uint16_t n, i;
+    uint8_t s0, s1, s2, s3, k, c;
+
+    if (universe < plan->universe || universe - plan->universe >= plan->universes)
+        return;
+    op = &plan->op[plan->opStart[universe - plan->universe]];
+    end = &plan->op[plan->opStart[universe - plan->universe + 1]];
+
+    for (; op < end; op++) {
+        if (op->slot >= count)
+            continue;
+
+        tab[0] = luts[op->output]->r;
+        tab[1] = luts[op->output]->g;
+        tab[2] = luts[op->output]->b;
+        tab[3] = luts[op->output]->w;
+        s = slots + op->slot;
+        d = levels[op->output] + op->dst;
+
+        /* Part of a pixel, channel by channel */
+        if (op->first != 0 || op->last != op->channels) {
+            for (k = 0; k < op->channels; k++) {
+                c = op->shuffle[k];
+                if (c >= op->first && c < op->last && op->slot + (c - op->first) < count)
+                    d[k] = tab[c][s[c - op->first]];
+            }
+            continue;
+        }
+
+        /* Short packets leave the pixels past their end alone */
+        n = op->count;
+        if (op->slot + n * op->channels > count)
+            n = (count - op->slot) / op->channels;
+
+        s0 = op->shuffle[0];
+        s1 = op->shuffle[1];
+        s2 = op->shuffle[2];
+        t0 = tab[s0];
+        t1 = tab[s1];
+        t2 = tab[s2];
+        if (op->channels == 3) {
+            for (i = 0; i < n; i++) {
+                d[0] = t0[s[s0]];
+                d[1] = t1[s[s1]];
+                d[2] = t2[s[s2]];
+                s += 3;
+                d += op->step;
+            }
+        } else {
+            s3 = op->shuffle[3];
+            t3 = tab[s3];
+            for (i = 0; i < n; i++) {
+                d[0] = t0[s[s0]];
+                d[1] = t1[s[s1]];
+                d[2] = t2[s[s2]];
+                d[3] = t3[s[s3]];
+                s += 4;
+                d += op->step;
+            }
+        }
+    }
+}
@@ -0,0 +1,103 @@
+/*
+ * pixel_map.h
+ *
+ *  Mapping from DMX slots to pixel outputs.
+ *
+ *  Each output is described by where its data starts (universe and slot),
+ *  how many pixels it has, the color order on the wire and the physical
+ *  layout (serpentine runs, reversed).  MAP_Compile() turns the outputs
+ *  into a plan of copy operations grouped by universe; each operation
+ *  moves a run of pixels that are contiguous in the universe and evenly
+ *  spaced on the output, so MAP_Apply() is a few straight loops per
+ *  universe with no per-pixel decisions.  A pixel whose channels straddle
+ *  two universes becomes one partial operation in each.
+ *
+ *  No hardware dependencies, built on the host by the tests.
+ */
+
+#ifndef PIXEL_MAP_H_
+#define PIXEL_MAP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "color_lut.h"
+
+#ifndef MAP_MAX_OUTPUTS
+#define MAP_MAX_OUTPUTS 16
+#endif
+#ifndef MAP_MAX_OPS
+#define MAP_MAX_OPS 256
+#endif
+#ifndef MAP_MAX_UNIVERSES
+#define MAP_MAX_UNIVERSES 32            /* Span from the first to the last universe used */
+#endif
+
+#define MAP_SLOTS 512                   /* Slots per universe, start code excluded */
+#define MAP_UNIVERSE_MAX 63999          /* Highest E1.31 universe */
+
+/* Wire color orders; the DMX data is always R, G, B (, W) */
+#define MAP_ORDER_RGB 0
+#define MAP_ORDER_RBG 1
+#define MAP_ORDER_GRB 2
+#define MAP_ORDER_GBR 3
+#define MAP_ORDER_BRG 4
+#define MAP_ORDER_BGR 5
+#define MAP_ORDER_RGBW 6
+#define MAP_ORDER_GRBW 7
+#define MAP_ORDER_CHANNELS(order) ((order) >= MAP_ORDER_RGBW ? 4 : 3)
+
+typedef struct _map_output
+{
+    uint16_t universe;                  /* Universe of the first pixel */
+    uint16_t channel;                   /* Slot of the first pixel, 1..512 */
+    uint16_t pixels;
+    uint16_t universePixels;            /* Pixels per universe before the next starts at slot 1,
+                                           0 runs channels straight across universes */
+    uint16_t zigzag;                    /* Pixels per serpentine run, every other run reversed, 0 for none */
+    uint8_t order;                      /* MAP_ORDER_ */
+    uint8_t reverse;                    /* First pixel at the far end of the strand */
+    uint16_t base;                      /* Index of the output's first channel in the level array */
+} map_output_t;
+
+typedef struct _map_op
+{
+    uint16_t slot;                      /* First source slot, 0 based */
+    uint16_t dst;                       /* Level index of the first pixel */
+    int16_t step;                       /* Level index step per pixel */
+    uint16_t count;                     /* Pixels */
+    uint8_t output;
+    uint8_t channels;                   /* Channels per pixel */
+    uint8_t first;                      /* Source channels first..last-1 of the pixel are in this */
+    uint8_t last;                       /* universe; anything but 0..channels is a single pixel */
+    uint8_t shuffle[4];                 /* Source channel of each wire channel */
+} map_op_t;
+
+typedef struct _map_plan
+{
+    uint16_t universe;                  /* First universe with operations */
+    uint16_t universes;                 /* Universes spanned */
+    uint16_t ops;
+    uint8_t outputs;
+    uint16_t opStart[MAP_MAX_UNIVERSES + 1]; /* Operations of universe + n are opStart[n]..opStart[n+1]-1 */
+    uint16_t lastUniverse[MAP_MAX_OUTPUTS];  /* Universe that completes each output */
+    map_op_t op[MAP_MAX_OPS];
+} map_plan_t;
+
+/* Returns 0, or -1 if an output is invalid or the outputs need more operations
+ * or universes than the plan holds.  Outputs without pixels are unused and
+ * always valid; the others need a universe in 1..MAP_UNIVERSE_MAX to the
+ * last pixel, a channel in 1..512, a known order, universePixels that fit
+ * in a universe from 'channel' on, zigzag runs no longer than the output
+ * and level indexes that fit in 16 bits. */
+int MAP_Compile(map_plan_t *plan, const map_output_t *outputs, uint8_t count);
+
+/* Copy the slots of one universe through each output's color table into
+ * that output's level array, indexed from the output's base */
+void MAP_Apply(const map_plan_t *plan, uint16_t universe, const uint8_t *slots, uint16_t count,
+               const color_lut16_t *const *luts, uint16_t *const *levels);
+
+/* Physical position of logical pixel p */
+uint16_t MAP_Position(const map_output_t *output, uint16_t p);
+
+#endif /* PIXEL_MAP_H_ */
@@ -0,0 +1,79 @@
+/*
+ * pixel_transpose.c
+ *
+ *  Bit-plane transposition for the parallel pixel outputs.
+ */
+
+#include "pixel_transpose.h"
+
+/*
+ * Transpose the 8x8 bit matrix held in x (strands 7..4, strand 7 in the top
+ * byte) and y (strands 3..0), using the three swap stages from Hacker's
+ * Delight 7-3.  Afterwards the top byte of x is the plane of bit 7 and the
+ * bottom byte of y the plane of bit 0.
+ */
+#define TRANSPOSE8(x, y, t) do { \
+    t = (x ^ (x >> 7)) & 0x00AA00AAU;  x = x ^ t ^ (t << 7); \
+    t = (y ^ (y >> 7)) & 0x00AA00AAU;  y = y ^ t ^ (t << 7); \
+    t = (x ^ (x >> 14)) & 0x0000CCCCU; x = x ^ t ^ (t << 14); \
+    t = (y ^ (y >> 14)) & 0x0000CCCCU; y = y ^ t ^ (t << 14); \
+    t = (x & 0xF0F0F0F0U) | ((y >> 4) & 0x0F0F0F0FU); \
+    y = ((x << 4) & 0xF0F0F0F0U) | (y & 0x0F0F0F0FU); \
+    x = t; \
+} while (0)
+
+/* Gather byte i of the four strands starting at s, the highest strand in the top byte */
+#define GATHER4(s, stride, i) \
+    (((uint32_t)(s)[3 * (stride) + (i)] << 24) | ((uint32_t)(s)[2 * (stride) + (i)] << 16) | \
+     ((uint32_t)(s)[1 * (stride) + (i)] << 8) | (uint32_t)(s)[(i)])
+
+void PIXEL_Transpose8(const uint8_t *src, size_t stride, size_t bytes, uint8_t *planes)
+{
+    const uint8_t *hi = src + 4 * stride;
+    uint32_t x, y, t;
+    size_t i;
+
+    for (i = 0; i < bytes; i++) {
+        x = GATHER4(hi, stride, i);
+        y = GATHER4(src, stride, i);
+        TRANSPOSE8(x, y, t);
+
+        planes[0] = (uint8_t)(x >> 24);
+        planes[1] = (uint8_t)(x >> 16);
+        planes[2] = (uint8_t)(x >> 8);
+        planes[3] = (uint8_t)x;
+        planes[4] = (uint8_t)(y >> 24);
+        planes[5] = (uint8_t)(y >> 16);
+        planes[6] = (uint8_t)(y >> 8);
+        planes[7] = (uint8_t)y;
+        planes += 8;
+    }
+}
+
+void PIXEL_Transpose16(const uint8_t *src, size_t stride, size_t bytes, uint16_t *planes)
+{
+    const uint8_t *s4 = src + 4 * stride;
+    const uint8_t *s8 = src + 8 * stride;
+    const uint8_t *s12 = src + 12 * stride;
+    uint32_t x0, y0, x1, y1, t;
+    size_t i;
+
+    for (i = 0; i < bytes; i++) {
+        x0 = GATHER4(s4, stride, i);
+        y0 = GATHER4(src, stride, i);
+        x1 = GATHER4(s12, stride, i);
+        y1 = GATHER4(s8, stride, i);
+        TRANSPOSE8(x0, y0, t);
+        TRANSPOSE8(x1, y1, t);
+
+        planes[0] = (uint16_t)(((x1 >> 16) & 0xFF00U) | (x0 >> 24));
+        planes[1] = (uint16_t)(((x1 >> 8) & 0xFF00U) | ((x0 >> 16) & 0xFFU));
+        planes[2] = (uint16_t)((x1 & 0xFF00U) | ((x0 >> 8) & 0xFFU));
+        planes[3] = (uint16_t)(((x1 << 8) & 0xFF00U) | (x0 & 0xFFU));
+        planes[4] = (uint16_t)(((y1 >> 16) & 0xFF00U) | (y0 >> 24));
+        planes[5] = (uint16_t)(((y1 >> 8) & 0xFF00U) | ((y0 >> 16) & 0xFFU));
+        planes[6] = (uint16_t)((y1 & 0xFF00U) | ((y0 >> 8) & 0xFFU));
+        planes[7] = (uint16_t)(((y1 << 8) & 0xFF00U) | (y0 & 0xFFU));
+        planes += 8;
+    }
+}
@@ -0,0 +1,26 @@
+/*
+ * pixel_transpose.h
+ *
+ *  Bit-plane transposition for the parallel pixel outputs.
+ *
+ *  Strand s holds its bytes at src[s * stride ...].  For every byte
+ *  position the kernels emit one plane per bit, MSB first, in which bit s
+ *  is that bit of strand s, ready to be written to a GPIO port with one
+ *  pin per strand.
+ *
+ *  No hardware dependencies, built on the host by the tests and benchmark.
+ */
+
+#ifndef PIXEL_TRANSPOSE_H_
+#define PIXEL_TRANSPOSE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* 8 strands, planes must hold bytes * 8 entries */
+void PIXEL_Transpose8(const uint8_t *src, size_t stride, size_t bytes, uint8_t *planes);
+
+/* 16 strands, planes must hold bytes * 8 entries */
+void PIXEL_Transpose16(const uint8_t *src, size_t stride, size_t bytes, uint16_t *planes);
+
+#endif /* PIXEL_TRANSPOSE_H_ */
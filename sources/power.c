@@ -0,0 +1,79 @@
+/*
+ * power.c
+ *
+ *  Current limiting of pixel strands.
+ */
+
+#include "power.h"
+
+/* Level sums per channel, then one multiply per channel: 340 pixels at
+ * 65535 stay well inside 32 bits */
+static uint32_t POWER_dynamic(const uint16_t *levels, uint16_t pixels, uint8_t channels, const power_budget_t *budget)
+{
+    uint32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    uint64_t total;
+    uint16_t i;
+
+    if (channels == 4) {
+        for (i = 0; i < pixels; i++) {
+            s0 += levels[0];
+            s1 += levels[1];
+            s2 += levels[2];
+            s3 += levels[3];
+            levels += 4;
+        }
+    } else {
+        for (i = 0; i < pixels; i++) {
+            s0 += levels[0];
+            s1 += levels[1];
+            s2 += levels[2];
+            levels += 3;
+        }
+    }
+
+    total = (uint64_t)s0 * budget->mA[0] + (uint64_t)s1 * budget->mA[1] + (uint64_t)s2 * budget->mA[2] +
+            (uint64_t)s3 * budget->mA[3];
+    return (uint32_t)((total + 32767U) / 65535U);
+}
+
+uint32_t POWER_Estimate(const uint16_t *levels, uint16_t pixels, uint8_t channels, const power_budget_t *budget)
+{
+    return POWER_dynamic(levels, pixels, channels, budget) + ((uint32_t)pixels * budget->idle + 500U) / 1000U;
+}
+
+uint32_t POWER_Limit(const uint16_t *levels, uint16_t pixels, uint8_t channels, const power_budget_t *budget,
+                     power_stats_t *stats)
+{
+    uint32_t dynamic, idle, scale;
+
+    dynamic = POWER_dynamic(levels, pixels, channels, budget);
+    idle = ((uint32_t)pixels * budget->idle + 500U) / 1000U;
+
+    stats->frames++;
+    stats->current = dynamic + idle;
+    if (stats->current > stats->peak)
+        stats->peak = stats->current;
+
+    if (budget->budget == 0 || dynamic + idle <= budget->budget)
+        return POWER_UNITY;
+
+    /* Only the part that depends on the levels can be scaled */
+    if (idle >= budget->budget)
+        scale = 0;
+    else
+        scale = (uint32_t)(((uint64_t)(budget->budget - idle) << 16) / dynamic);
+
+    stats->limited++;
+    if (scale < stats->lowest)
+        stats->lowest = scale;
+    return scale;
+}
+
+void POWER_ResetStats(power_stats_t *stats)
+{
+    stats->frames = 0;
+    stats->limited = 0;
+    stats->current = 0;
+    stats->peak = 0;
+    stats->lowest = POWER_UNITY;
+}
@@ -0,0 +1,49 @@
+/*
+ * power.h
+ *
+ *  Current limiting of pixel strands.
+ *
+ *  The current a strand draws is estimated from its 16 bit levels, which
+ *  are linear in PWM duty after the color tables, as a per channel current
+ *  at full level plus a quiescent current per pixel.  When the estimate
+ *  exceeds the budget the whole strand is scaled down by the same factor,
+ *  keeping its colors.  The estimate is one read-only pass; the scale is
+ *  applied by the dithering pass that follows anyway (DITHER_Apply()).
+ *
+ *  No hardware dependencies, built on the host by the tests.
+ */
+
+#ifndef POWER_H_
+#define POWER_H_
+
+#include <stdint.h>
+
+#define POWER_UNITY 65536U              /* Scale that leaves the levels alone */
+
+typedef struct _power_budget
+{
+    uint16_t mA[4];                     /* Current of each channel of a pixel at full level, wire order */
+    uint16_t idle;                      /* Quiescent current per pixel, uA */
+    uint32_t budget;                    /* mA the strand may draw, 0 for no limit */
+} power_budget_t;
+
+typedef struct _power_stats
+{
+    uint32_t frames;                    /* Refreshes estimated */
+    uint32_t limited;                   /* Refreshes scaled down */
+    uint32_t current;                   /* mA the last refresh asked for */
+    uint32_t peak;                      /* Most mA asked for */
+    uint32_t lowest;                    /* Lowest scale applied, POWER_UNITY if never limited */
+} power_stats_t;
+
+/* mA drawn by 'pixels' pixels of 'channels' levels each */
+uint32_t POWER_Estimate(const uint16_t *levels, uint16_t pixels, uint8_t channels, const power_budget_t *budget);
+
+/* Estimate, account in 'stats' and return the scale, 0..POWER_UNITY, that keeps the strand within budget */
+uint32_t POWER_Limit(const uint16_t *levels, uint16_t pixels, uint8_t channels, const power_budget_t *budget,
+                     power_stats_t *stats);
+
+/* Clear the counters */
+void POWER_ResetStats(power_stats_t *stats);
+
+#endif /* POWER_H_ */
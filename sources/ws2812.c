@@ -0,0 +1,75 @@
+/*
+ * ws2812.c
+ *
+ *  WS2812/SK6812 bit encoder.
+ */
+
+#include "ws2812.h"
+
+/* Datasheet high times and latch time, in ns */
+#define WS2812_T0H 400U
+#define WS2812_T1H 800U
+#define WS2812_RESET 300000U
+#define SK6812_T0H 300U
+#define SK6812_T1H 600U
+#define SK6812_RESET 80000U
+
+#define WS2812_PERIOD (1000000000U / WS2812_BIT_RATE)
+
+/* Timer counts in 'ns' at 'clock', rounded to nearest */
+static uint16_t WS2812_counts(uint32_t clock, uint32_t ns)
+{
+    return (uint16_t)(((clock / 1000U) * ns + 500000U) / 1000000U);
+}
+
+void WS2812_GetTiming(ws2812_timing_t *timing, ws2812_type_t type, uint32_t srcClock_Hz)
+{
+    uint32_t reset;
+
+    timing->mod = (uint16_t)(srcClock_Hz / WS2812_BIT_RATE - 1U);
+    if (type == kWS2812_TypeSK6812) {
+        timing->t0h = WS2812_counts(srcClock_Hz, SK6812_T0H);
+        timing->t1h = WS2812_counts(srcClock_Hz, SK6812_T1H);
+        reset = SK6812_RESET;
+    } else {
+        timing->t0h = WS2812_counts(srcClock_Hz, WS2812_T0H);
+        timing->t1h = WS2812_counts(srcClock_Hz, WS2812_T1H);
+        reset = WS2812_RESET;
+    }
+
+    /* The driver stops the timer on the last DMA request, which cuts the
+     * final period short, so add one */
+    timing->resetPeriods = (uint16_t)((reset + WS2812_PERIOD - 1U) / WS2812_PERIOD + 1U);
+}
+
+/*
+ * Encode 'bytes' of wire-order pixel data MSB first into 'cnv', which must
+ * hold WS2812_BUFFER_ENTRIES(bytes) values.  Returns the number written.
+ */
+size_t WS2812_Encode(const ws2812_timing_t *timing, const uint8_t *data, size_t bytes, uint16_t *cnv)
+{
+    const uint16_t t0h = timing->t0h;
+    const uint16_t t1h = timing->t1h;
+    uint16_t *p = cnv;
+    size_t i;
+    uint8_t v;
+
+    for (i = 0; i < bytes; i++) {
+        v = data[i];
+        p[0] = (v & 0x80) ? t1h : t0h;
+        p[1] = (v & 0x40) ? t1h : t0h;
+        p[2] = (v & 0x20) ? t1h : t0h;
+        p[3] = (v & 0x10) ? t1h : t0h;
+        p[4] = (v & 0x08) ? t1h : t0h;
+        p[5] = (v & 0x04) ? t1h : t0h;
+        p[6] = (v & 0x02) ? t1h : t0h;
+        p[7] = (v & 0x01) ? t1h : t0h;
+        p += 8;
+    }
+
+    /* CnV of 0 holds the line low for the whole period */
+    for (i = 0; i < timing->resetPeriods; i++)
+        *p++ = 0;
+
+    return (size_t)(p - cnv);
+}
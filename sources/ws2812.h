@@ -0,0 +1,96 @@
+/*
+ * ws2812.h
+ *
+ *  WS2812/SK6812 pixel output.
+ *
+ *  Every data bit becomes one FTM PWM period whose compare value sets the
+ *  high time.  The encoder turns wire-order pixel bytes into a buffer of
+ *  16 bit CnV values followed by enough zero periods to latch the strip;
+ *  the driver streams that buffer into FTM CnV with DMA, one value per
+ *  channel match, so the CPU only touches the strip to encode the frame.
+ *
+ *  The encoder has no hardware dependencies and is built on the host by
+ *  the unit tests.
+ */
+
+#ifndef WS2812_H_
+#define WS2812_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define WS2812_BIT_RATE 800000U         /* 1.25 us per bit */
+#define WS2812_BYTES_PER_PIXEL 3
+#define WS2812_RESET_MAX_PERIODS 241    /* 300 us of low line, plus the period cut short by the stop */
+
+#ifndef WS2812_MAX_PIXELS
+#define WS2812_MAX_PIXELS 340           /* Two full universes of RGB */
+#endif
+
+/* Compare values needed to encode 'bytes' of pixel data plus the latch */
+#define WS2812_BUFFER_ENTRIES(bytes) ((bytes) * 8U + WS2812_RESET_MAX_PERIODS)
+
+/* Output hardware */
+#ifndef WS2812_FTM
+#define WS2812_FTM FTM0
+#define WS2812_FTM_CHANNEL 0U
+#define WS2812_PORT PORTC
+#define WS2812_PORT_CLOCK kCLOCK_PortC
+#define WS2812_PIN 1U                   /* PTC1 = FTM0_CH0 on Alt4 */
+#define WS2812_PIN_MUX kPORT_MuxAlt4
+#define WS2812_DMA_CHANNEL 0U
+#define WS2812_DMA_SOURCE kDmaRequestMux0FTM0Channel0
+#define WS2812_DMA_HANDLER DMA0_IRQHandler
+#endif
+
+/* Parallel output: one GPIO pin per strand, all strands clocked together.
+ * FTM3 channels 0..2 match at the start of each bit, at T0H and at T1H,
+ * and each requests a DMA write to the port: all pins high, the bit plane,
+ * all pins low. */
+#ifndef WS2812PORT_STRANDS
+#define WS2812PORT_STRANDS 8            /* 8 or 16, on pins 0..STRANDS-1 */
+#endif
+#ifndef WS2812PORT_MAX_PIXELS
+#define WS2812PORT_MAX_PIXELS 340       /* Per strand */
+#endif
+#ifndef WS2812PORT_FTM
+#define WS2812PORT_FTM FTM3
+#define WS2812PORT_FTM_HANDLER FTM3_IRQHandler
+#define WS2812PORT_FTM_IRQ FTM3_IRQn
+#define WS2812PORT_FTM_SOURCE kDmaRequestMux0FTM3Channel0  /* Channels 1 and 2 follow */
+#define WS2812PORT_PORT PORTD
+#define WS2812PORT_PORT_CLOCK kCLOCK_PortD
+#define WS2812PORT_GPIO GPIOD
+#define WS2812PORT_DMA_CHANNEL 1U       /* Uses this channel and the next two */
+#define WS2812PORT_DMA_HANDLER DMA3_IRQHandler  /* Handler of the last of the three */
+#endif
+
+typedef enum _ws2812_type
+{
+    kWS2812_TypeWS2812 = 0,             /* T0H 0.40 us, T1H 0.80 us, reset > 280 us */
+    kWS2812_TypeSK6812,                 /* T0H 0.30 us, T1H 0.60 us, reset > 80 us */
+} ws2812_type_t;
+
+typedef struct _ws2812_timing
+{
+    uint16_t mod;                       /* FTM MOD for one bit period */
+    uint16_t t0h;                       /* CnV for a 0 bit */
+    uint16_t t1h;                       /* CnV for a 1 bit */
+    uint16_t resetPeriods;              /* Zero periods appended to latch the strip */
+} ws2812_timing_t;
+
+void WS2812_GetTiming(ws2812_timing_t *timing, ws2812_type_t type, uint32_t srcClock_Hz);
+size_t WS2812_Encode(const ws2812_timing_t *timing, const uint8_t *data, size_t bytes, uint16_t *cnv);
+
+/* FTM + DMA driver */
+void WS2812_Init(ws2812_type_t type);
+bool WS2812_Show(const uint8_t *data, size_t bytes);
+bool WS2812_IsBusy(void);
+
+/* GPIO port + DMA driver, strand s starts at data + s * stride */
+void WS2812PORT_Init(ws2812_type_t type);
+bool WS2812PORT_Show(const uint8_t *data, size_t stride, size_t bytes);
+bool WS2812PORT_IsBusy(void);
+
+#endif /* WS2812_H_ */
@@ -0,0 +1,100 @@
+/*
+ * ws2812_ftm.c
+ *
+ *  WS2812/SK6812 driver: edge-aligned PWM on one FTM channel with the
+ *  channel match requesting DMA.  Each request writes the next CnV, which
+ *  the FTM loads at the following counter overflow, so the value for bit
+ *  n+1 is in place before bit n finishes.  The DMA major loop interrupt
+ *  stops the timer once the trailing zero periods have latched the strip.
+ */
+
+#include "ws2812.h"
+#include "dma_chan.h"
+
+#include "fsl_clock.h"
+#include "fsl_ftm.h"
+#include "fsl_port.h"
+
+#define WS2812_SOURCE_CLOCK CLOCK_GetFreq(kCLOCK_BusClk)
+
+static ws2812_timing_t timing;
+static uint16_t cnv[WS2812_BUFFER_ENTRIES(WS2812_MAX_PIXELS * WS2812_BYTES_PER_PIXEL)];
+static volatile bool busy;
+
+void WS2812_DMA_HANDLER(void)
+{
+    DMACHAN_ClearInterrupt(WS2812_DMA_CHANNEL);
+
+    FTM_StopTimer(WS2812_FTM);
+    WS2812_FTM->CONTROLS[WS2812_FTM_CHANNEL].CnSC &= ~(FTM_CnSC_DMA_MASK | FTM_CnSC_CHIE_MASK | FTM_CnSC_CHF_MASK);
+    busy = false;
+}
+
+void WS2812_Init(ws2812_type_t type)
+{
+    ftm_config_t ftmInfo;
+    ftm_chnl_pwm_signal_param_t ftmParam;
+
+    CLOCK_EnableClock(WS2812_PORT_CLOCK);
+    PORT_SetPinMux(WS2812_PORT, WS2812_PIN, WS2812_PIN_MUX);
+
+    WS2812_GetTiming(&timing, type, WS2812_SOURCE_CLOCK);
+
+    ftmParam.chnlNumber = (ftm_chnl_t)WS2812_FTM_CHANNEL;
+    ftmParam.level = kFTM_HighTrue;
+    ftmParam.dutyCyclePercent = 0U;
+    ftmParam.firstEdgeDelayPercent = 0U;
+
+    FTM_GetDefaultConfig(&ftmInfo);
+    FTM_Init(WS2812_FTM, &ftmInfo);
+    FTM_SetupPwm(WS2812_FTM, &ftmParam, 1U, kFTM_EdgeAlignedPwm, WS2812_BIT_RATE, WS2812_SOURCE_CLOCK);
+    WS2812_FTM->MOD = timing.mod;
+
+    DMACHAN_Init();
+}
+
+bool WS2812_IsBusy(void)
+{
+    return busy;
+}
+
+/*
+ * Start sending 'bytes' of wire-order pixel data.  Returns false without
+ * touching the strip if the previous frame is still going out.
+ */
+bool WS2812_Show(const uint8_t *data, size_t bytes)
+{
+    dmachan_transfer_t transfer;
+    size_t count;
+
+    if (busy)
+        return false;
+
+    if (bytes > WS2812_MAX_PIXELS * WS2812_BYTES_PER_PIXEL)
+        bytes = WS2812_MAX_PIXELS * WS2812_BYTES_PER_PIXEL;
+    count = WS2812_Encode(&timing, data, bytes, cnv);
+
+    /* With the counter stopped CnV loads immediately, so the first bit is
+     * written by hand and DMA supplies the rest */
+    FTM_StopTimer(WS2812_FTM);
+    WS2812_FTM->CONTROLS[WS2812_FTM_CHANNEL].CnV = cnv[0];
+    WS2812_FTM->CNT = 0;
+    WS2812_FTM->CONTROLS[WS2812_FTM_CHANNEL].CnSC &= ~FTM_CnSC_CHF_MASK;
+    WS2812_FTM->CONTROLS[WS2812_FTM_CHANNEL].CnSC |= FTM_CnSC_DMA_MASK | FTM_CnSC_CHIE_MASK;
+
+    transfer.source = (uint8_t)WS2812_DMA_SOURCE;
+    transfer.src = &cnv[1];
+    transfer.srcOffset = sizeof(cnv[0]);
+    transfer.srcSize = kDMACHAN_Size16;
+    transfer.dst = &WS2812_FTM->CONTROLS[WS2812_FTM_CHANNEL].CnV;
+    transfer.dstOffset = 0;
+    transfer.dstSize = kDMACHAN_Size16;
+    transfer.count = (uint16_t)(count - 1U);
+    transfer.interrupt = true;
+
+    busy = true;
+    DMACHAN_Start(WS2812_DMA_CHANNEL, &transfer);
+    FTM_StartTimer(WS2812_FTM, kFTM_SystemClock);
+
+    return true;
+}
@@ -0,0 +1,179 @@
+/*
+ * ws2812_port.c
+ *
+ *  Parallel WS2812/SK6812 driver, OctoWS2811 style.
+ *
+ *  FTM3 runs at the bit rate with its channels used only as match events.
+ *  Each bit period three DMA channels write the port: PSOR with all strand
+ *  pins at the start, PDOR with the bit plane at T0H (strands sending a 0
+ *  drop, strands sending a 1 stay high) and PCOR with all pins at T1H.
+ *  When the last bit is out the timer is reprogrammed for a single reset
+ *  period and its overflow ends the frame.
+ */
+
+#include "ws2812.h"
+#include "dma_chan.h"
+#include "pixel_transpose.h"
+
+#include "fsl_clock.h"
+#include "fsl_ftm.h"
+#include "fsl_port.h"
+
+#define WS2812PORT_SOURCE_CLOCK CLOCK_GetFreq(kCLOCK_BusClk)
+#define WS2812PORT_BYTES (WS2812PORT_MAX_PIXELS * WS2812_BYTES_PER_PIXEL)
+
+#if WS2812PORT_STRANDS == 16
+typedef uint16_t ws2812port_plane_t;
+#define WS2812PORT_SIZE kDMACHAN_Size16
+#define WS2812PORT_TRANSPOSE PIXEL_Transpose16
+#elif WS2812PORT_STRANDS == 8
+typedef uint8_t ws2812port_plane_t;
+#define WS2812PORT_SIZE kDMACHAN_Size8
+#define WS2812PORT_TRANSPOSE PIXEL_Transpose8
+#else
+#error "WS2812PORT_STRANDS must be 8 or 16"
+#endif
+
+#define WS2812PORT_PINS ((1U << WS2812PORT_STRANDS) - 1U)
+
+static ws2812_timing_t timing;
+static uint32_t resetMod;
+static ws2812port_plane_t planes[WS2812PORT_BYTES * 8];
+static const ws2812port_plane_t ones = (ws2812port_plane_t)WS2812PORT_PINS;
+static volatile bool busy;
+
+/* Match events: start of bit, T0H, T1H */
+static void WS2812PORT_matches(uint32_t enable)
+{
+    uint32_t ch;
+
+    for (ch = 0; ch < 3; ch++) {
+        if (enable) {
+            WS2812PORT_FTM->CONTROLS[ch].CnSC &= ~FTM_CnSC_CHF_MASK;
+            WS2812PORT_FTM->CONTROLS[ch].CnSC |= FTM_CnSC_DMA_MASK | FTM_CnSC_CHIE_MASK;
+        } else {
+            WS2812PORT_FTM->CONTROLS[ch].CnSC &= ~(FTM_CnSC_DMA_MASK | FTM_CnSC_CHIE_MASK | FTM_CnSC_CHF_MASK);
+        }
+    }
+}
+
+/* T1H of the last bit has been written, hold the lines low for the latch */
+void WS2812PORT_DMA_HANDLER(void)
+{
+    DMACHAN_ClearInterrupt(WS2812PORT_DMA_CHANNEL + 2U);
+
+    FTM_StopTimer(WS2812PORT_FTM);
+    WS2812PORT_matches(0);
+    WS2812PORT_FTM->MOD = resetMod;
+    WS2812PORT_FTM->CNT = 0;
+    FTM_ClearStatusFlags(WS2812PORT_FTM, kFTM_TimeOverflowFlag);
+    FTM_EnableInterrupts(WS2812PORT_FTM, kFTM_TimeOverflowInterruptEnable);
+    FTM_StartTimer(WS2812PORT_FTM, kFTM_SystemClock);
+}
+
+void WS2812PORT_FTM_HANDLER(void)
+{
+    FTM_StopTimer(WS2812PORT_FTM);
+    FTM_DisableInterrupts(WS2812PORT_FTM, kFTM_TimeOverflowInterruptEnable);
+    FTM_ClearStatusFlags(WS2812PORT_FTM, kFTM_TimeOverflowFlag);
+    WS2812PORT_FTM->MOD = timing.mod;
+    busy = false;
+}
+
+void WS2812PORT_Init(ws2812_type_t type)
+{
+    ftm_config_t ftmInfo;
+    ftm_chnl_pwm_signal_param_t ftmParam[3];
+    uint32_t i;
+
+    CLOCK_EnableClock(WS2812PORT_PORT_CLOCK);
+    for (i = 0; i < WS2812PORT_STRANDS; i++)
+        PORT_SetPinMux(WS2812PORT_PORT, i, kPORT_MuxAsGpio);
+    WS2812PORT_GPIO->PCOR = WS2812PORT_PINS;
+    WS2812PORT_GPIO->PDDR |= WS2812PORT_PINS;
+
+    WS2812_GetTiming(&timing, type, WS2812PORT_SOURCE_CLOCK);
+    resetMod = (uint32_t)timing.resetPeriods * (timing.mod + 1U);
+    if (resetMod > 0xFFFFU)
+        resetMod = 0xFFFFU;
+
+    /* The channel pins stay unrouted, only the match events are used */
+    for (i = 0; i < 3; i++) {
+        ftmParam[i].chnlNumber = (ftm_chnl_t)i;
+        ftmParam[i].level = kFTM_HighTrue;
+        ftmParam[i].dutyCyclePercent = 0U;
+        ftmParam[i].firstEdgeDelayPercent = 0U;
+    }
+
+    FTM_GetDefaultConfig(&ftmInfo);
+    FTM_Init(WS2812PORT_FTM, &ftmInfo);
+    FTM_SetupPwm(WS2812PORT_FTM, ftmParam, 3U, kFTM_EdgeAlignedPwm, WS2812_BIT_RATE, WS2812PORT_SOURCE_CLOCK);
+
+    /* Offset by one count so the first match doesn't coincide with the reload */
+    WS2812PORT_FTM->MOD = timing.mod;
+    WS2812PORT_FTM->CONTROLS[0].CnV = 1U;
+    WS2812PORT_FTM->CONTROLS[1].CnV = 1U + timing.t0h;
+    WS2812PORT_FTM->CONTROLS[2].CnV = 1U + timing.t1h;
+
+    EnableIRQ(WS2812PORT_FTM_IRQ);
+    DMACHAN_Init();
+}
+
+bool WS2812PORT_IsBusy(void)
+{
+    return busy;
+}
+
+/*
+ * Start sending 'bytes' of wire-order pixel data on every strand.  Returns
+ * false without touching the strands if the previous frame is still going out.
+ */
+bool WS2812PORT_Show(const uint8_t *data, size_t stride, size_t bytes)
+{
+    dmachan_transfer_t transfer;
+    uint16_t count;
+
+    if (busy)
+        return false;
+
+    if (bytes > WS2812PORT_BYTES)
+        bytes = WS2812PORT_BYTES;
+    if (bytes == 0)
+        return true;
+    WS2812PORT_TRANSPOSE(data, stride, bytes, planes);
+    count = (uint16_t)(bytes * 8U);
+
+    FTM_StopTimer(WS2812PORT_FTM);
+    WS2812PORT_FTM->CNT = 0;
+    WS2812PORT_matches(1);
+
+    transfer.srcSize = WS2812PORT_SIZE;
+    transfer.dstOffset = 0;
+    transfer.dstSize = WS2812PORT_SIZE;
+    transfer.count = count;
+
+    transfer.source = (uint8_t)WS2812PORT_FTM_SOURCE;
+    transfer.src = &ones;
+    transfer.srcOffset = 0;
+    transfer.dst = &WS2812PORT_GPIO->PSOR;
+    transfer.interrupt = false;
+    DMACHAN_Start(WS2812PORT_DMA_CHANNEL, &transfer);
+
+    transfer.source = (uint8_t)WS2812PORT_FTM_SOURCE + 1U;
+    transfer.src = planes;
+    transfer.srcOffset = sizeof(planes[0]);
+    transfer.dst = &WS2812PORT_GPIO->PDOR;
+    DMACHAN_Start(WS2812PORT_DMA_CHANNEL + 1U, &transfer);
+
+    transfer.source = (uint8_t)WS2812PORT_FTM_SOURCE + 2U;
+    transfer.src = &ones;
+    transfer.srcOffset = 0;
+    transfer.dst = &WS2812PORT_GPIO->PCOR;
+    transfer.interrupt = true;
+    DMACHAN_Start(WS2812PORT_DMA_CHANNEL + 2U, &transfer);
+
+    busy = true;
+    FTM_StartTimer(WS2812PORT_FTM, kFTM_SystemClock);
+
+    return true;
+}
@@ -0,0 +1,200 @@
+/*
+ * fuzz_e131.c
+ *
+ *  Fuzz target of the E1.31 receive path.  Each input is one datagram
+ *  after a first byte that picks where its pbuf chain splits, 0 for a
+ *  single pbuf.  The datagram goes through E131_parseBuffer() from a buffer
+ *  of exactly its size, and through E131_parsePbuf(), the parser behind
+ *  both lwIP listeners, as PBUF_REF pbufs over separate allocations, so a
+ *  read past either end is caught by the address sanitizer.
+ *
+ *  With clang it is a libFuzzer target (E131_LIBFUZZER):
+ *
+ *    ./fuzz_e131 corpus/
+ *
+ *  Otherwise main() runs the files named on the command line, or with none
+ *  a fixed number of random mutations of valid data and sync packets.  It
+ *  links the host lwIP, see the fuzz_e131 target in CMakeLists.txt.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "E131_lwip.h"
+
+#include "lwip/init.h"
+#include "lwip/pbuf.h"
+
+#define MUTATIONS 200000
+
+static uint32_t clock_ms;
+
+u32_t sys_now(void)
+{
+    return clock_ms;
+}
+
+static void setup(void)
+{
+    static int ready;
+
+    if (ready)
+        return;
+    ready = 1;
+    lwip_init();
+    E131_init();
+}
+
+/* A pbuf over its own copy of raw */
+static struct pbuf *refPbuf(const uint8_t *raw, uint16_t len, uint8_t **copy)
+{
+    struct pbuf *p;
+
+    *copy = malloc(len);
+    if (!*copy)
+        return NULL;
+    memcpy(*copy, raw, len);
+    p = pbuf_alloc(PBUF_RAW, len, PBUF_REF);
+    if (p)
+        p->payload = *copy;
+    return p;
+}
+
+/* The datagram as one pbuf, or split after 'split' bytes */
+static void parseChain(const uint8_t *raw, uint16_t size, uint16_t split)
+{
+    uint8_t *a = NULL, *b = NULL;
+    struct pbuf *p, *q = NULL;
+
+    p = refPbuf(raw, split, &a);
+    if (p && split < size) {
+        q = refPbuf(raw + split, size - split, &b);
+        if (q)
+            pbuf_cat(p, q);
+    }
+    if (p && (split == size || q))
+        E131_parsePbuf(p);
+    if (p)
+        pbuf_free(p);
+    free(a);
+    free(b);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    uint8_t *raw;
+    uint16_t n, split;
+
+    setup();
+    if (size < 2 || size > 0xffff)
+        return 0;
+    n = (uint16_t)(size - 1);
+    split = data[0] ? (uint16_t)(1 + (data[0] - 1) * (n - 1) / 255) : n;
+    clock_ms += 10;
+
+    raw = malloc(n);
+    if (!raw)
+        return 0;
+    memcpy(raw, data + 1, n);
+    E131_parseBuffer(raw, n);
+    free(raw);
+
+    parseChain(data + 1, n, split);
+    return 0;
+}
+
+#ifndef E131_LIBFUZZER
+static uint32_t rng = 2463534242U;
+
+static uint32_t next(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+/* Data packet of 'slots' levels to a universe in the table, or a sync packet, returns its size */
+static uint16_t seed(uint8_t *p, int sync, uint16_t slots)
+{
+    uint16_t size = sync ? E131_SYNC_SIZE : E131_DMP_DATA + slots + 1;
+
+    memset(p, 0, sizeof(e131_packet_t));
+    put16(p + E131_ROOT_PREAMBLE_SIZE, E131_PREAMBLE_SIZE);
+    memcpy(p + E131_ROOT_ID, ACN_ID, sizeof(ACN_ID));
+    put16(p + E131_ROOT_FLENGTH, (uint16_t)(E131_PDU_FLAGS | (size - E131_ROOT_FLENGTH)));
+    p[E131_ROOT_VECTOR + 3] = sync ? 8 : 4;
+    put16(p + E131_FRAME_FLENGTH, (uint16_t)(E131_PDU_FLAGS | (size - E131_FRAME_FLENGTH)));
+    p[E131_FRAME_VECTOR + 3] = sync ? 1 : 2;
+    if (sync) {
+        put16(p + E131_SYNC_ADDR, 1);
+        return size;
+    }
+    p[E131_FRAME_PRIORITY] = E131_PRIORITY_DEFAULT;
+    p[E131_FRAME_SEQ] = (uint8_t)next();
+    put16(p + E131_FRAME_UNIVERSE, (uint16_t)(E131_DEFAULT_UNIVERSE + next() % E131_DEFAULT_UNIVERSE_COUNT));
+    put16(p + E131_DMP_FLENGTH, (uint16_t)(E131_PDU_FLAGS | (size - E131_DMP_FLENGTH)));
+    p[E131_DMP_VECTOR] = VECTOR_DMP;
+    p[E131_DMP_TYPE] = E131_DMP_ADDRESS_TYPE;
+    put16(p + E131_DMP_ADDR_INC, 1);
+    put16(p + E131_DMP_COUNT, (uint16_t)(slots + 1));
+    return size;
+}
+
+static int runFile(const char *path)
+{
+    static uint8_t buf[0x10000];
+    FILE *f = fopen(path, "rb");
+    size_t n;
+
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    n = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+    LLVMFuzzerTestOneInput(buf, n);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static uint8_t input[1 + sizeof(e131_packet_t) + 16];
+    uint32_t i, k, edits;
+    uint16_t size;
+    int failed = 0;
+
+    if (argc > 1) {
+        for (i = 1; i < (uint32_t)argc; i++)
+            failed |= runFile(argv[i]);
+        return failed;
+    }
+
+    for (i = 0; i < MUTATIONS; i++) {
+        size = seed(input + 1, next() % 8 == 0, (uint16_t)(next() % E131_UNIVERSE_SIZE));
+        input[0] = (uint8_t)next();
+
+        /* A few bytes flipped, then maybe a length changed by a little */
+        edits = next() % 4;
+        for (k = 0; k < edits; k++)
+            input[1 + next() % size] ^= (uint8_t)(1U << (next() % 8));
+        if (next() % 2)
+            size = (uint16_t)(size + next() % 32 - 16);
+        if (size > sizeof(input) - 1)
+            size = sizeof(input) - 1;
+
+        LLVMFuzzerTestOneInput(input, (size_t)size + 1);
+    }
+
+    printf("%u inputs, core: %u valid, %u packet errors, %u sequence errors\n", MUTATIONS, stats.num_packets,
+           stats.packet_errors, stats.sequence_errors);
+    return stats.num_packets ? 0 : 1;
+}
+#endif
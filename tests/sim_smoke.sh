@@ -0,0 +1,74 @@
+#!/bin/sh
+#
+# sim_smoke.sh
+#
+#  Smoke test of the Linux build (sim/): brings k64f_sim up on a TAP
+#  interface of its own, sends it a few seconds of sACN with sacn_gen and
+#  checks that the firmware resolved its address over ARP and recorded
+#  frames carrying the levels it was sent.  Needs root (or CAP_NET_ADMIN)
+#  and /dev/net/tun, exits 77 (skipped) without them.
+#
+#  sh tests/sim_smoke.sh build/k64f_sim build/sacn_gen
+
+SIM=$1
+GEN=$2
+TAP=${SIM_SMOKE_TAP:-k64fsim0}
+HOST_ADDR=192.168.1.1
+SIM_ADDR=192.168.1.102
+
+[ -x "$SIM" ] && [ -x "$GEN" ] || { echo "usage: $0 k64f_sim sacn_gen"; exit 2; }
+[ -c /dev/net/tun ] || { echo "no /dev/net/tun, skipped"; exit 77; }
+command -v ip >/dev/null || { echo "no ip command, skipped"; exit 77; }
+ip tuntap add dev "$TAP" mode tap 2>/dev/null || { echo "cannot create $TAP, skipped"; exit 77; }
+
+DIR=$(mktemp -d)
+PID=
+cleanup() {
+    [ -n "$PID" ] && kill "$PID" 2>/dev/null && wait "$PID" 2>/dev/null
+    ip tuntap del dev "$TAP" mode tap 2>/dev/null
+    rm -rf "$DIR"
+}
+trap cleanup EXIT
+fail() {
+    echo "sim_smoke: $*"
+    echo "--- k64f_sim output"
+    cat "$DIR/sim.log"
+    exit 1
+}
+
+ip addr add "$HOST_ADDR/24" dev "$TAP" || exit 1
+ip link set "$TAP" up || exit 1
+ip route get "$SIM_ADDR" | grep -q "dev $TAP" || { echo "$SIM_ADDR is not routed to $TAP, skipped"; exit 77; }
+
+SIM_TAP=$TAP SIM_FRAMES=$DIR/frames.bin "$SIM" >"$DIR/sim.log" 2>&1 &
+PID=$!
+
+# Up once it has printed its address, the first packets also wait for ARP
+up=0
+for i in 1 2 3 4 5 6 7 8 9 10; do
+    if grep -q "IPv4 Address" "$DIR/sim.log"; then
+        up=1
+        break
+    fi
+    kill -0 "$PID" 2>/dev/null || fail "exited during start up"
+    sleep 1
+done
+[ $up = 1 ] || fail "did not start"
+
+"$GEN" -a "$SIM_ADDR" -u 1,8 -r 40 -t 2 >"$DIR/gen.log" 2>&1 || fail "sacn_gen failed: $(cat "$DIR/gen.log")"
+sleep 1
+kill -0 "$PID" 2>/dev/null || fail "exited while receiving"
+ip neigh show "$SIM_ADDR" dev "$TAP" | grep -q lladdr || fail "no ARP reply"
+
+# Frames are a 32 bit little endian length and the bytes; the first one is the blank strip
+[ -s "$DIR/frames.bin" ] || fail "no frames recorded"
+size=$(wc -c <"$DIR/frames.bin")
+len=$(od -An -tu1 -N4 "$DIR/frames.bin" | awk '{ print $1 + 256 * ($2 + 256 * ($3 + 256 * $4)) }')
+[ "$len" -gt 0 ] || fail "empty frame"
+frames=$((size / (len + 4)))
+nonzero=$(tr -d '\000' <"$DIR/frames.bin" | wc -c)
+[ "$frames" -ge 2 ] || fail "$frames frame recorded"
+[ "$nonzero" -gt $((frames * 4)) ] || fail "$frames frames, all dark"
+
+echo "sim_smoke: $frames frames of $len bytes"
+exit 0
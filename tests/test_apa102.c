@@ -0,0 +1,176 @@
+/*
+ * test_apa102.c
+ *
+ *  Host test of the APA102/SK9822 frame builder.
+ *
+ *  cc -Isources tests/test_apa102.c sources/apa102.c -o test_apa102
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "apa102.h"
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static void test_layout(void)
+{
+    static const size_t counts[] = { 0, 1, 16, 31, 32, 33, 170, 510 };
+    static uint8_t rgb[510 * 3];
+    static uint8_t frame[APA102_FRAME_BYTES(510) + 1];
+    size_t c, i, n, pixels, end;
+
+    memset(rgb, 0x80, sizeof(rgb));
+    for (c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        pixels = counts[c];
+        memset(frame, 0xEE, sizeof(frame));
+        n = APA102_Encode(rgb, pixels, APA102_BRIGHTNESS_MAX, frame);
+
+        CHECK(n == APA102_FRAME_BYTES(pixels));
+        CHECK(n % 2 == 0);
+        CHECK(frame[n] == 0xEE);
+
+        /* Start frame */
+        for (i = 0; i < APA102_START_BYTES; i++)
+            CHECK(frame[i] == 0);
+
+        /* Every pixel word starts with 111 */
+        for (i = 0; i < pixels; i++)
+            CHECK((frame[APA102_START_BYTES + i * 4] & 0xE0) == 0xE0);
+
+        /* Zero word for SK9822, then at least one clock per two pixels */
+        end = APA102_START_BYTES + pixels * 4;
+        for (i = end; i < n; i++)
+            CHECK(frame[i] == 0);
+        CHECK((n - end - 4) * 8 >= pixels / 2);
+    }
+}
+
+static void test_pixels(void)
+{
+    uint8_t rgb[3];
+    uint8_t px[4];
+    unsigned g, m, seed;
+    double want, got;
+    int i, k;
+
+    /* Full white at full brightness is passed through */
+    rgb[0] = rgb[1] = rgb[2] = 255;
+    APA102_EncodePixels(rgb, 1, 31, px);
+    CHECK(px[0] == 0xFF && px[1] == 255 && px[2] == 255 && px[3] == 255);
+
+    /* Wire order is blue, green, red */
+    rgb[0] = 255;
+    rgb[1] = 128;
+    rgb[2] = 1;
+    APA102_EncodePixels(rgb, 1, 31, px);
+    CHECK(px[0] == 0xFF && px[1] == 1 && px[2] == 128 && px[3] == 255);
+
+    /* Black */
+    rgb[0] = rgb[1] = rgb[2] = 0;
+    APA102_EncodePixels(rgb, 1, 31, px);
+    CHECK(px[1] == 0 && px[2] == 0 && px[3] == 0);
+
+    /* A dim pixel runs at low current with a high PWM value */
+    rgb[0] = rgb[1] = rgb[2] = 10;
+    APA102_EncodePixels(rgb, 1, 31, px);
+    CHECK((px[0] & 0x1F) == 2);
+    CHECK(px[3] == 155);
+
+    /* Light output c/255 * brightness/31 is kept to within half a PWM step
+     * at the chosen current, for random colors and every brightness */
+    seed = 1;
+    for (g = 0; g <= 31; g++) {
+        for (i = 0; i < 200; i++) {
+            for (k = 0; k < 3; k++) {
+                seed = seed * 1103515245U + 12345U;
+                rgb[k] = (uint8_t)(seed >> 16);
+            }
+            APA102_EncodePixels(rgb, 1, (uint8_t)g, px);
+
+            m = rgb[0] > rgb[1] ? rgb[0] : rgb[1];
+            m = m > rgb[2] ? m : rgb[2];
+            CHECK((px[0] & 0x1F) >= 1);
+            if (m && g)
+                CHECK((px[0] & 0x1F) == (m * g + 254) / 255);
+
+            for (k = 0; k < 3; k++) {
+                want = rgb[k] / 255.0 * g / 31.0;
+                got = px[3 - k] / 255.0 * (px[0] & 0x1F) / 31.0;
+                CHECK(got - want < 0.5 / 255.0 * (px[0] & 0x1F) / 31.0 + 1e-9);
+                CHECK(want - got < 0.5 / 255.0 * (px[0] & 0x1F) / 31.0 + 1e-9);
+            }
+        }
+    }
+}
+
+static void test_pixels16(void)
+{
+    uint16_t levels[3];
+    uint8_t rgb[3];
+    uint8_t px[4], px8[4];
+    uint8_t frame[APA102_FRAME_BYTES(1)];
+    unsigned g, seed;
+    int i, k;
+
+    /* A level 8 bits round to 0 gets the lowest current and some PWM */
+    levels[0] = 100;
+    levels[1] = 0;
+    levels[2] = 0;
+    APA102_EncodePixels16(levels, 1, 31, 65536U, px);
+    CHECK((px[0] & 0x1F) == 1);
+    CHECK(px[3] == 12 && px[2] == 0 && px[1] == 0);
+
+    /* Dim but above 8 bit zero: a small header and more than 8 bit PWM */
+    levels[0] = levels[1] = levels[2] = 3000;
+    APA102_EncodePixels16(levels, 1, 31, 65536U, px);
+    CHECK((px[0] & 0x1F) == 2);
+    CHECK(px[3] == 181);
+
+    /* Full white, and half of it through the scale */
+    levels[0] = levels[1] = levels[2] = 65535;
+    APA102_EncodePixels16(levels, 1, 31, 65536U, px);
+    CHECK(px[0] == 0xFF && px[1] == 255 && px[2] == 255 && px[3] == 255);
+    APA102_EncodePixels16(levels, 1, 31, 32768U, px);
+    CHECK((px[0] & 0x1F) == 16);
+
+    /* 8 bit values widened to 16 encode as the 8 bit encoder does */
+    seed = 5;
+    for (g = 0; g <= 31; g++) {
+        for (i = 0; i < 200; i++) {
+            for (k = 0; k < 3; k++) {
+                seed = seed * 1103515245U + 12345U;
+                rgb[k] = (uint8_t)(seed >> 16);
+                levels[k] = (uint16_t)(rgb[k] * 257U);
+            }
+            APA102_EncodePixels(rgb, 1, (uint8_t)g, px8);
+            APA102_EncodePixels16(levels, 1, (uint8_t)g, 65536U, px);
+            CHECK(memcmp(px, px8, sizeof(px)) == 0);
+        }
+    }
+
+    CHECK(APA102_Encode16(levels, 1, 31, 65536U, frame) == APA102_FRAME_BYTES(1));
+    CHECK(memcmp(frame + APA102_START_BYTES, px, sizeof(px)) == 0);
+}
+
+int main(void)
+{
+    test_layout();
+    test_pixels();
+    test_pixels16();
+
+    if (failures) {
+        printf("test_apa102: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_apa102: ok\n");
+    return 0;
+}
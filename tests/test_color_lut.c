@@ -0,0 +1,76 @@
+/*
+ * test_color_lut.c
+ *
+ *  Host test of the gamma and white balance tables.
+ *
+ *  cc -Isources tests/test_color_lut.c sources/color_lut.c -lm -o test_color_lut
+ */
+
+#include <stdio.h>
+
+#include "color_lut.h"
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+int main(void)
+{
+    static color_lut8_t l8;
+    static color_lut16_t l16;
+    color_correction_t linear = { 1.0f, { 255, 255, 255, 255 } };
+    color_correction_t led = { 2.2f, { 255, 200, 100, 50 } };
+    uint8_t px[6] = { 0, 128, 255, 255, 255, 255 };
+    int i, d;
+
+    /* Linear and full white is the identity */
+    COLORLUT_Build8(&l8, &linear);
+    COLORLUT_Build16(&l16, &linear);
+    for (i = 0; i < 256; i++) {
+        CHECK(l8.r[i] == i && l8.g[i] == i && l8.b[i] == i);
+        CHECK(l16.r[i] == i * 257 && l16.w[i] == i * 257);
+    }
+
+    COLORLUT_Build8(&l8, &led);
+    COLORLUT_Build16(&l16, &led);
+
+    /* End points follow the white point */
+    CHECK(l8.r[0] == 0 && l8.g[0] == 0 && l8.b[0] == 0);
+    CHECK(l8.r[255] == 255 && l8.g[255] == 200 && l8.b[255] == 100 && l8.w[255] == 50);
+    CHECK(l16.r[255] == 65535 && l16.g[255] == 51400 && l16.b[255] == 25700);
+
+    /* Gamma pulls the middle down: (128/255)^2.2 = 0.2195 */
+    CHECK(l8.r[128] == 56);
+    CHECK(l16.r[128] >= 14384 && l16.r[128] <= 14388);
+
+    for (i = 1; i < 256; i++) {
+        /* Monotonic */
+        CHECK(l8.r[i] >= l8.r[i - 1] && l8.g[i] >= l8.g[i - 1] && l8.b[i] >= l8.b[i - 1]);
+        CHECK(l16.r[i] >= l16.r[i - 1]);
+
+        /* The 8 bit table is the 16 bit one rounded */
+        d = (l16.g[i] + 128) / 257 - l8.g[i];
+        CHECK(d >= -1 && d <= 1);
+    }
+
+    /* Low levels keep resolution in 16 bits where 8 bits round to zero */
+    CHECK(l8.r[10] == 0);
+    CHECK(l16.r[10] > 0);
+
+    /* Applied in place */
+    COLORLUT_Apply8(&l8, px, 2, px);
+    CHECK(px[0] == 0 && px[1] == l8.g[128] && px[2] == 100);
+    CHECK(px[3] == 255 && px[4] == 200 && px[5] == 100);
+
+    if (failures) {
+        printf("test_color_lut: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_color_lut: ok\n");
+    return 0;
+}
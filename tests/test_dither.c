@@ -0,0 +1,82 @@
+/*
+ * test_dither.c
+ *
+ *  Host test of the temporal dithering.
+ *
+ *  cc -Isources tests/test_dither.c sources/dither.c -o test_dither
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dither.h"
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+#define REFRESHES 256
+
+int main(void)
+{
+    static uint16_t src[65536];
+    static uint8_t residual[65536];
+    static uint8_t dst[65536];
+    static uint32_t sum[65536];
+    static uint8_t lo[65536], hi[65536];
+    uint32_t v;
+    int r;
+
+    for (v = 0; v < 65536; v++)
+        src[v] = (uint16_t)v;
+    memset(residual, 0, sizeof(residual));
+    memset(lo, 0xFF, sizeof(lo));
+
+    for (r = 0; r < REFRESHES; r++) {
+        DITHER_Apply(src, residual, 65536, DITHER_UNITY, dst);
+        for (v = 0; v < 65536; v++) {
+            sum[v] += dst[v];
+            if (dst[v] < lo[v])
+                lo[v] = dst[v];
+            if (dst[v] > hi[v])
+                hi[v] = dst[v];
+        }
+    }
+
+    for (v = 0; v < 65536; v++) {
+        /* The average over 256 refreshes is the 16 bit value, to 1/256 of a step */
+        double want = v * 255.0 / 65535.0;
+        double got = sum[v] / (double)REFRESHES;
+        CHECK(got - want < 1.0 / 256 + 0.004 && want - got < 1.0 / 256 + 0.004);
+
+        /* Only ever toggles between the two neighbouring 8 bit levels */
+        CHECK(hi[v] - lo[v] <= 1);
+
+        /* Exact 8 bit levels are steady */
+        if (v % 257 == 0)
+            CHECK(lo[v] == v / 257 && hi[v] == v / 257);
+    }
+
+    /* Rounding without carry */
+    DITHER_Round(src, 65536, DITHER_UNITY, dst);
+    CHECK(dst[0] == 0 && dst[65535] == 255 && dst[257 * 100] == 100);
+    CHECK(dst[257 * 100 + 120] == 100 && dst[257 * 100 + 137] == 101);
+
+    /* Scaled on the way */
+    DITHER_Round(src, 65536, DITHER_UNITY / 2, dst);
+    CHECK(dst[0] == 0 && dst[65535] == 128 && dst[257 * 100] == 50);
+    DITHER_Round(src, 65536, 0, dst);
+    CHECK(dst[65535] == 0);
+
+    if (failures) {
+        printf("test_dither: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_dither: ok\n");
+    return 0;
+}
@@ -0,0 +1,365 @@
+/*
+ * test_e131.c
+ *
+ *  Host test of the E1.31 core: validation, sequence and priority
+ *  handling, synchronization, the source table and source loss with the
+ *  loss policies.  Built twice, the second time with E131_HTP_MERGE:
+ *
+ *  cc -Isources tests/test_e131.c sources/E131.c sources/loss.c -o test_e131
+ *  cc -Isources -DE131_HTP_MERGE=1 tests/test_e131.c sources/E131.c sources/loss.c -o test_e131_htp
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "E131.h"
+#include "loss.h"
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static uint32_t clock_ms = 1000;
+static e131_universe_t *latched;
+static unsigned callbacks;
+static unsigned losses;
+
+uint32_t E131_now(void)
+{
+    return clock_ms;
+}
+
+static void received(e131_universe_t *u)
+{
+    latched = u;
+    callbacks++;
+}
+
+static void lost(e131_universe_t *u, uint32_t elapsed, uint32_t step)
+{
+    losses++;
+    LOSS_Update(u, elapsed, step);
+}
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    put16(p, (uint16_t)(v >> 16));
+    put16(p + 2, (uint16_t)v);
+}
+
+/* Data packet of 'slots' levels all at 'level', returns its size */
+static uint16_t packet(uint8_t *p, uint8_t source, uint16_t universe, uint8_t sequence, uint8_t priority,
+                       uint8_t options, uint16_t sync, uint16_t slots, uint8_t level)
+{
+    static const uint8_t acn[12] = { 0x41, 0x53, 0x43, 0x2d, 0x45, 0x31, 0x2e, 0x31, 0x37, 0x00, 0x00, 0x00 };
+    uint16_t size = E131_DMP_DATA + slots + 1;
+
+    memset(p, 0, sizeof(e131_packet_t));
+    put16(p + E131_ROOT_PREAMBLE_SIZE, 0x0010);
+    memcpy(p + E131_ROOT_ID, acn, sizeof(acn));
+    put16(p + E131_ROOT_FLENGTH, (uint16_t)(0x7000 | (size - 16)));
+    put32(p + E131_ROOT_VECTOR, 4);
+    memset(p + E131_ROOT_CID, source, 16);
+    put16(p + E131_FRAME_FLENGTH, (uint16_t)(0x7000 | (size - 38)));
+    put32(p + E131_FRAME_VECTOR, 2);
+    p[E131_FRAME_PRIORITY] = priority;
+    put16(p + E131_FRAME_SYNCADDR, sync);
+    p[E131_FRAME_SEQ] = sequence;
+    p[E131_FRAME_OPT] = options;
+    put16(p + E131_FRAME_UNIVERSE, universe);
+    put16(p + E131_DMP_FLENGTH, (uint16_t)(0x7000 | (size - 115)));
+    p[E131_DMP_VECTOR] = 2;
+    p[E131_DMP_TYPE] = 0xa1;
+    put16(p + E131_DMP_ADDR_INC, 1);
+    put16(p + E131_DMP_COUNT, (uint16_t)(slots + 1));
+    memset(p + E131_DMP_DATA + 1, level, slots);
+    return size;
+}
+
+static uint16_t syncPacket(uint8_t *p, uint16_t address)
+{
+    static const uint8_t acn[12] = { 0x41, 0x53, 0x43, 0x2d, 0x45, 0x31, 0x2e, 0x31, 0x37, 0x00, 0x00, 0x00 };
+
+    memset(p, 0, E131_SYNC_SIZE);
+    put16(p + E131_ROOT_PREAMBLE_SIZE, 0x0010);
+    memcpy(p + E131_ROOT_ID, acn, sizeof(acn));
+    put16(p + E131_ROOT_FLENGTH, (uint16_t)(0x7000 | (E131_SYNC_SIZE - 16)));
+    put32(p + E131_ROOT_VECTOR, 8);
+    put16(p + E131_FRAME_FLENGTH, (uint16_t)(0x7000 | (E131_SYNC_SIZE - 38)));
+    put32(p + E131_FRAME_VECTOR, 1);
+    put16(p + E131_SYNC_ADDR, address);
+    return E131_SYNC_SIZE;
+}
+
+/* Universe discovery packet listing 'count' universes from 1 */
+static uint16_t discoveryPacket(uint8_t *p, uint16_t count)
+{
+    static const uint8_t acn[12] = { 0x41, 0x53, 0x43, 0x2d, 0x45, 0x31, 0x2e, 0x31, 0x37, 0x00, 0x00, 0x00 };
+    uint16_t size = (uint16_t)(E131_DISCOVERY_SIZE + count * 2);
+    uint16_t i;
+
+    memset(p, 0, size);
+    put16(p + E131_ROOT_PREAMBLE_SIZE, 0x0010);
+    memcpy(p + E131_ROOT_ID, acn, sizeof(acn));
+    put16(p + E131_ROOT_FLENGTH, (uint16_t)(0x7000 | (size - 16)));
+    put32(p + E131_ROOT_VECTOR, 8);
+    put16(p + E131_FRAME_FLENGTH, (uint16_t)(0x7000 | (size - 38)));
+    put32(p + E131_FRAME_VECTOR, 2);
+    put16(p + E131_DISCOVERY_FLENGTH, (uint16_t)(0x7000 | (size - 112)));
+    put32(p + E131_DISCOVERY_VECTOR, 1);
+    for (i = 0; i < count; i++)
+        put16(p + E131_DISCOVERY_SIZE + i * 2, (uint16_t)(i + 1));
+    return size;
+}
+
+int main(void)
+{
+    static uint8_t p[sizeof(e131_packet_t)];
+    static uint8_t scene[512];
+    loss_policy_t policy;
+    e131_universe_t *u;
+    uint32_t errors;
+    uint16_t size;
+    unsigned i;
+
+    E131_init();
+    E131_setCallback(received);
+    E131_setLossCallback(lost);
+    CHECK(E131_firstUniverse() == E131_DEFAULT_UNIVERSE);
+    CHECK(E131_universeCount() == E131_DEFAULT_UNIVERSE_COUNT);
+
+    /* Validation */
+    size = packet(p, 1, 1, 0, 100, 0, 0, 512, 10);
+    CHECK(validate((const e131_packet_t *)p, size) == ERROR_NONE);
+    CHECK(validate((const e131_packet_t *)p, E131_DMP_DATA - 1) == ERROR_PACKET_SIZE);
+    CHECK(validate((const e131_packet_t *)p, size - 1) == ERROR_PACKET_SIZE);
+    p[E131_ROOT_ID] = 0;
+    CHECK(validate((const e131_packet_t *)p, size) == ERROR_ACN_ID);
+    size = packet(p, 1, 1, 0, 100, 0, 0, 512, 10);
+    p[E131_ROOT_VECTOR + 3] = 5;
+    CHECK(validate((const e131_packet_t *)p, size) == ERROR_VECTOR_ROOT);
+    size = packet(p, 1, 1, 0, 100, 0, 0, 512, 10);
+    p[E131_FRAME_VECTOR + 3] = 3;
+    CHECK(validate((const e131_packet_t *)p, size) == ERROR_VECTOR_FRAME);
+    size = packet(p, 1, 1, 0, 100, 0, 0, 512, 10);
+    p[E131_DMP_VECTOR] = 1;
+    CHECK(validate((const e131_packet_t *)p, size) == ERROR_VECTOR_DMP);
+    size = packet(p, 1, 1, 0, 100, 0, 0, 512, 10);
+    put16(p + E131_DMP_COUNT, 514);
+    CHECK(validate((const e131_packet_t *)p, sizeof(p)) == ERROR_PACKET_SIZE);
+    put16(p + E131_DMP_COUNT, 0);
+    CHECK(validate((const e131_packet_t *)p, size) == ERROR_PACKET_SIZE);
+
+    /* Every PDU length runs to the end of the datagram, with flags 0x7 */
+    size = packet(p, 1, 1, 0, 100, 0, 0, 512, 10);
+    CHECK(validate((const e131_packet_t *)p, size + 1) == ERROR_PACKET_SIZE);
+    p[E131_ROOT_FLENGTH] = 0x62;
+    CHECK(validate((const e131_packet_t *)p, size) == ERROR_PACKET_SIZE);
+    size = packet(p, 1, 1, 0, 100, 0, 0, 512, 10);
+    p[E131_FRAME_FLENGTH + 1]++;
+    CHECK(validate((const e131_packet_t *)p, size) == ERROR_PACKET_SIZE);
+    size = packet(p, 1, 1, 0, 100, 0, 0, 512, 10);
+    p[E131_DMP_FLENGTH + 1]--;
+    CHECK(validate((const e131_packet_t *)p, size) == ERROR_PACKET_SIZE);
+    size = packet(p, 1, 1, 0, 100, 0, 0, 4, 10);
+    put16(p + E131_DMP_COUNT, 4);
+    CHECK(validate((const e131_packet_t *)p, size) == ERROR_PACKET_SIZE);
+    CHECK(E131_parseBuffer(p, size) == 0);
+    size = packet(p, 1, 1, 0, 100, 0, 0, 512, 10);
+    p[E131_ROOT_PREAMBLE_SIZE + 1] = 0x20;
+    CHECK(validate((const e131_packet_t *)p, size) == ERROR_ACN_ID);
+    size = packet(p, 1, 1, 0, 100, 0, 0, 512, 10);
+    p[E131_DMP_TYPE] = 0xa2;
+    CHECK(validate((const e131_packet_t *)p, size) == ERROR_VECTOR_DMP);
+    size = packet(p, 1, 1, 0, 100, 0, 0, 512, 10);
+    put16(p + E131_DMP_ADDR_INC, 2);
+    CHECK(validate((const e131_packet_t *)p, size) == ERROR_VECTOR_DMP);
+    size = syncPacket(p, 7);
+    CHECK(validateSync((const e131_sync_packet_t *)p, size) == ERROR_NONE);
+    CHECK(validateSync((const e131_sync_packet_t *)p, size + 1) == ERROR_PACKET_SIZE);
+    p[E131_FRAME_FLENGTH + 1]++;
+    CHECK(validateSync((const e131_sync_packet_t *)p, size) == ERROR_PACKET_SIZE);
+
+    /* Universe discovery is counted on its own, not as a packet error */
+    errors = stats.packet_errors;
+    size = discoveryPacket(p, 8);
+    CHECK(validateDiscovery((const e131_sync_packet_t *)p, size) == ERROR_NONE);
+    CHECK(E131_parseBuffer(p, size) == 0);
+    CHECK(stats.discovery == 1 && stats.packet_errors == errors);
+    size = discoveryPacket(p, 0);
+    CHECK(E131_parseBuffer(p, size) == 0);
+    CHECK(stats.discovery == 2 && stats.packet_errors == errors);
+    CHECK(validateDiscovery((const e131_sync_packet_t *)p, size - 1) == ERROR_PACKET_SIZE);
+    size = discoveryPacket(p, 8);
+    put32(p + E131_DISCOVERY_VECTOR, 2);
+    CHECK(validateDiscovery((const e131_sync_packet_t *)p, size) == ERROR_VECTOR_FRAME);
+    CHECK(E131_parseBuffer(p, size) == 0);
+    CHECK(stats.discovery == 2 && stats.packet_errors == errors + 1);
+    size = syncPacket(p, 7);
+    CHECK(validateDiscovery((const e131_sync_packet_t *)p, size) == ERROR_PACKET_SIZE);
+
+    /* Data lands in its universe */
+    size = packet(p, 1, 2, 0, 100, 0, 0, 512, 10);
+    CHECK(E131_parseBuffer(p, size) == 512);
+    u = E131_getUniverse(2);
+    CHECK(latched == u && callbacks == 1);
+    CHECK(E131_universeNumber(u) == 2 && u->length == 513 && u->data[0] == 0 && u->data[512] == 10);
+    CHECK(universe == 2 && data == u->data + 1);
+
+    /* Alternate start codes keep the source in sequence but never reach the levels */
+    size = packet(p, 1, 2, 1, 100, 0, 0, 512, 77);
+    p[E131_DMP_DATA] = 0xdd;
+    CHECK(E131_parseBuffer(p, size) == 0 && callbacks == 1 && u->data[0] == 0 && u->data[512] == 10);
+    CHECK(u->stats.start_codes == 1 && u->stats.num_packets == 1);
+    CHECK(E131_parseBuffer(p, size) == 0 && u->stats.sequence_errors == 1);
+    u->stats.sequence_errors = 0;
+    stats.sequence_errors = 0;
+
+    /* Universes outside the table are dropped */
+    size = packet(p, 1, 100, 0, 100, 0, 0, 512, 10);
+    CHECK(E131_parseBuffer(p, size) == 0 && callbacks == 1);
+
+    /* Duplicates and stale sequence numbers are dropped, far behind is a restart */
+    size = packet(p, 1, 2, 1, 100, 0, 0, 512, 11);
+    CHECK(E131_parseBuffer(p, size) == 0);
+    size = packet(p, 1, 2, 2, 100, 0, 0, 512, 11);
+    CHECK(E131_parseBuffer(p, size) == 512 && u->data[1] == 11);
+    size = packet(p, 1, 2, (uint8_t)(2 - 19), 100, 0, 0, 512, 12);
+    CHECK(E131_parseBuffer(p, size) == 0);
+    size = packet(p, 1, 2, (uint8_t)(2 - 20), 100, 0, 0, 512, 12);
+    CHECK(E131_parseBuffer(p, size) == 512 && u->data[1] == 12);
+    CHECK(u->stats.sequence_errors == 2);
+
+    /* A higher priority source takes over, the lower one is ignored while it lasts */
+    size = packet(p, 2, 2, 0, 150, 0, 0, 100, 50);
+    CHECK(E131_parseBuffer(p, size) == 100 && u->data[1] == 50);
+    size = packet(p, 1, 2, 200, 100, 0, 0, 512, 13);
+    CHECK(E131_parseBuffer(p, size) == 0 && u->data[1] == 50);
+    clock_ms += E131_SOURCE_TIMEOUT + 1;
+    size = packet(p, 1, 2, 201, 100, 0, 0, 512, 14);
+    CHECK(E131_parseBuffer(p, size) == 512 && u->data[1] == 14);
+
+    /* Synchronized data waits for its sync packet once syncs flow */
+    size = packet(p, 1, 3, 0, 100, 0, 7, 512, 20);
+    CHECK(E131_parseBuffer(p, size) == 512);
+    size = syncPacket(p, 7);
+    E131_parseBuffer(p, size);
+    size = packet(p, 1, 3, 1, 100, 0, 7, 512, 21);
+    CHECK(E131_parseBuffer(p, size) == 0 && E131_getUniverse(3)->data[1] == 20);
+    size = syncPacket(p, 7);
+    E131_parseBuffer(p, size);
+    CHECK(E131_getUniverse(3)->data[1] == 21);
+
+    /* Stream terminated: the data is ignored and the universe is lost at the next poll */
+    losses = 0;
+    E131_poll(clock_ms);
+    CHECK(losses == 0);
+    size = packet(p, 1, 2, 202, 100, E131_OPT_TERMINATED, 0, 512, 99);
+    CHECK(E131_parseBuffer(p, size) == 0 && u->data[1] == 14);
+    E131_poll(clock_ms);
+    CHECK(u->lost && losses == 1);
+
+    /* The default policy holds the last look; universe 3 has timed out meanwhile */
+    clock_ms += 10000;
+    E131_poll(clock_ms);
+    CHECK(u->data[1] == 14 && E131_getUniverse(3)->lost && losses == 3);
+
+    /* Hold 100 ms then fade to black over 200 ms */
+    policy.hold = 100;
+    policy.fade = 200;
+    policy.scene = NULL;
+    CHECK(LOSS_SetPolicy(4, &policy) == 0);
+    u = E131_getUniverse(4);
+    size = packet(p, 1, 4, 0, 100, 0, 0, 512, 200);
+    E131_parseBuffer(p, size);
+    clock_ms += E131_SOURCE_TIMEOUT + 1;
+    E131_poll(clock_ms);
+    CHECK(u->lost && u->data[1] == 200);
+    clock_ms += 100;
+    E131_poll(clock_ms);
+    CHECK(u->data[1] == 200);
+    clock_ms += 100;
+    E131_poll(clock_ms);
+    CHECK(u->data[1] == 100 && u->data[512] == 100);
+    clock_ms += 150;
+    E131_poll(clock_ms);
+    CHECK(u->data[1] == 0 && u->data[512] == 0);
+
+    /* A returning source takes over */
+    size = packet(p, 1, 4, 1, 100, 0, 0, 512, 30);
+    CHECK(E131_parseBuffer(p, size) == 512 && !u->lost && u->data[1] == 30);
+
+    /* Cut straight to a scene, also covering the slots a short universe lacked */
+    memset(scene, 77, sizeof(scene));
+    policy.hold = 0;
+    policy.fade = 0;
+    policy.scene = scene;
+    CHECK(LOSS_SetPolicy(5, &policy) == 0);
+    u = E131_getUniverse(5);
+    size = packet(p, 1, 5, 0, 100, 0, 0, 10, 1);
+    E131_parseBuffer(p, size);
+    clock_ms += E131_SOURCE_TIMEOUT + 1;
+    E131_poll(clock_ms);
+    CHECK(u->length == 513 && u->data[1] == 77 && u->data[512] == 77);
+
+    /* A full source table keeps its live sources, a new one is dropped until a slot times out */
+    u = E131_getUniverse(6);
+    for (i = 0; i < E131_MAX_SOURCES; i++) {
+        size = packet(p, (uint8_t)(10 + i), 6, 0, 100, 0, 0, 512, (uint8_t)(10 + i));
+        E131_parseBuffer(p, size);
+    }
+    CHECK(E131_liveSources(u, clock_ms) == E131_MAX_SOURCES);
+    size = packet(p, 20, 6, 0, 100, 0, 0, 512, 90);
+    CHECK(E131_parseBuffer(p, size) == 0 && u->stats.source_drops == 1 && u->data[1] != 90);
+    CHECK(E131_liveSources(u, clock_ms) == E131_MAX_SOURCES);
+    clock_ms += E131_SOURCE_TIMEOUT - 100;
+    size = packet(p, 10, 6, 1, 100, 0, 0, 512, 30);
+    CHECK(E131_parseBuffer(p, size) == 512);
+    clock_ms += 200;
+    size = packet(p, 20, 6, 1, 100, 0, 0, 512, 90);
+    CHECK(E131_parseBuffer(p, size) == 512 && u->data[1] == 90 && u->stats.source_drops == 1);
+    CHECK(E131_liveSources(u, clock_ms) == 2);
+
+    /* Equal priorities merge slot by slot with HTP, otherwise the latest packet wins */
+    u = E131_getUniverse(7);
+    size = packet(p, 1, 7, 0, 100, 0, 0, 512, 40);
+    p[E131_DMP_DATA + 1] = 200;
+    CHECK(E131_parseBuffer(p, size) == 512);
+    size = packet(p, 2, 7, 0, 100, 0, 0, 256, 60);
+#if E131_HTP_MERGE
+    CHECK(E131_parseBuffer(p, size) == 512);
+    CHECK(u->data[1] == 200 && u->data[2] == 60 && u->data[256] == 60 && u->data[257] == 40);
+#else
+    CHECK(E131_parseBuffer(p, size) == 256);
+    CHECK(u->data[1] == 60 && u->length == 257);
+#endif
+
+    /* A higher priority source still overrides the merge */
+    size = packet(p, 3, 7, 0, 150, 0, 0, 512, 5);
+    CHECK(E131_parseBuffer(p, size) == 512 && u->data[1] == 5 && u->data[512] == 5);
+
+    /* Policies are dropped with NULL and the table has a limit */
+    CHECK(LOSS_SetPolicy(5, NULL) == 0);
+    CHECK(LOSS_SetPolicy(4, NULL) == 0);
+    for (size = 0; size < LOSS_MAX_POLICIES; size++)
+        CHECK(LOSS_SetPolicy((uint16_t)(100 + size), &policy) == 0);
+    CHECK(LOSS_SetPolicy(200, &policy) == -1);
+
+    if (failures) {
+        printf("test_e131: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_e131: ok\n");
+    return 0;
+}
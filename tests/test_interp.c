@@ -0,0 +1,89 @@
+/*
+ * test_interp.c
+ *
+ *  Host test of the frame blending.  Built with INTERP_EMULATE_SIMD so the
+ *  SIMD path runs on emulated instructions and can be held to the C
+ *  reference bit for bit.
+ *
+ *  cc -DINTERP_EMULATE_SIMD -Isources tests/test_interp.c sources/interp.c -o test_interp
+ */
+
+#include <stdio.h>
+
+#include "interp.h"
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+#define N 511   /* Odd, to cover the scalar tail */
+
+int main(void)
+{
+    static uint16_t prev[N], cur[N], ref[N], simd[N];
+    static const uint32_t weights[] = { 0, 1, 2, 100, 8192, 16384, 16385, 32000, 32767, 32768, 40000 };
+    uint32_t seed = 7;
+    size_t i, w;
+    double want;
+    int mismatches;
+
+    for (i = 0; i < N; i++) {
+        seed = seed * 1103515245U + 12345U;
+        prev[i] = (uint16_t)(seed >> 8);
+        seed = seed * 1103515245U + 12345U;
+        cur[i] = (uint16_t)(seed >> 8);
+    }
+    /* Extremes */
+    prev[0] = 0;      cur[0] = 65535;
+    prev[1] = 65535;  cur[1] = 0;
+    prev[2] = 65535;  cur[2] = 65535;
+    prev[3] = 0;      cur[3] = 0;
+
+    for (w = 0; w < sizeof(weights) / sizeof(weights[0]); w++) {
+        INTERP_BlendRef(prev, cur, N, weights[w], ref);
+        INTERP_Blend(prev, cur, N, weights[w], simd);
+
+        mismatches = 0;
+        for (i = 0; i < N; i++) {
+            if (ref[i] != simd[i])
+                mismatches++;
+
+            /* Within rounding of the exact blend */
+            want = prev[i] + ((double)cur[i] - prev[i]) * (weights[w] > 32768 ? 32768 : weights[w]) / 32768.0;
+            CHECK(ref[i] - want <= 0.5 && want - ref[i] <= 0.5);
+        }
+        CHECK(mismatches == 0);
+    }
+
+    /* End points are exact */
+    INTERP_Blend(prev, cur, N, 0, simd);
+    CHECK(simd[0] == 0 && simd[1] == 65535 && simd[N - 1] == prev[N - 1]);
+    INTERP_Blend(prev, cur, N, INTERP_ONE, simd);
+    CHECK(simd[0] == 65535 && simd[1] == 0 && simd[N - 1] == cur[N - 1]);
+
+    /* In place over prev */
+    INTERP_BlendRef(prev, cur, N, 16384, ref);
+    INTERP_Blend(prev, cur, N, 16384, prev);
+    for (i = 0; i < N; i++)
+        CHECK(prev[i] == ref[i]);
+
+    /* Weights from arrival times */
+    CHECK(INTERP_Weight(0, 25, 100) == 0);
+    CHECK(INTERP_Weight(10, 40, 100) == INTERP_ONE / 4);
+    CHECK(INTERP_Weight(40, 40, 100) == INTERP_ONE);
+    CHECK(INTERP_Weight(60, 40, 100) == INTERP_ONE);
+    CHECK(INTERP_Weight(10, 0, 100) == INTERP_ONE);
+    CHECK(INTERP_Weight(10, 500, 100) == INTERP_ONE);
+
+    if (failures) {
+        printf("test_interp: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_interp: ok\n");
+    return 0;
+}
@@ -0,0 +1,222 @@
+/*
+ * test_output.c
+ *
+ *  Host test of the output path with interpolation, on the POSIX port of
+ *  the kernel.  The WS2812 driver and the clock are stand-ins: universes go
+ *  through OUTPUT_Update() at set times and the refresh task's frames are
+ *  read back from WS2812_Show().  Built with OUTPUT_INTERPOLATE=1 and
+ *  OUTPUT_DITHER=0, see the test_output target in CMakeLists.txt, and again
+ *  in parallel mode, where the frames come from WS2812PORT_Show() and a
+ *  strand dropped from the map has to go dark.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "output.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+#define PIXELS 10
+
+static map_output_t maps[2];           /* Strand 0 on universe 1, strand 1 on universe 2 */
+static volatile uint32_t clock_ms;
+static volatile uint8_t shown[3];      /* First pixel of the last frame shown */
+#if OUTPUT_MODE == OUTPUT_PARALLEL
+static volatile uint8_t second[3];     /* First pixel of strand 1 */
+#endif
+static volatile uint32_t shows;
+
+uint32_t E131_now(void)
+{
+    return clock_ms;
+}
+
+int SIM_Printf(const char *format, ...)
+{
+    va_list ap;
+    int n;
+
+    va_start(ap, format);
+    portENTER_CRITICAL();
+    n = vprintf(format, ap);
+    portEXIT_CRITICAL();
+    va_end(ap);
+    return n;
+}
+
+void vApplicationIdleHook(void)
+{
+    pause();
+}
+
+#if OUTPUT_MODE == OUTPUT_PARALLEL
+void WS2812PORT_Init(ws2812_type_t type)
+{
+    (void)type;
+}
+
+bool WS2812PORT_Show(const uint8_t *data, size_t stride, size_t bytes)
+{
+    if (bytes >= 3) {
+        shown[0] = data[0];
+        shown[1] = data[1];
+        shown[2] = data[2];
+        second[0] = data[stride];
+        second[1] = data[stride + 1];
+        second[2] = data[stride + 2];
+    }
+    shows++;
+    return true;
+}
+
+bool WS2812PORT_IsBusy(void)
+{
+    return false;
+}
+#else
+void WS2812_Init(ws2812_type_t type)
+{
+    (void)type;
+}
+
+bool WS2812_Show(const uint8_t *data, size_t bytes)
+{
+    if (bytes >= 3) {
+        shown[0] = data[0];
+        shown[1] = data[1];
+        shown[2] = data[2];
+    }
+    shows++;
+    return true;
+}
+
+bool WS2812_IsBusy(void)
+{
+    return false;
+}
+#endif
+
+/* One frame of a universe at 'level', received at 'now' */
+static void receive(e131_universe_t *u, uint32_t now, uint8_t level)
+{
+    clock_ms = now;
+    u->data = u->buff1;
+    u->data[0] = 0;
+    memset(u->data + 1, level, PIXELS * 3);
+    u->length = 1 + PIXELS * 3;
+    OUTPUT_Update(u);
+}
+
+/* Long enough for a couple of refreshes */
+static void settle(void)
+{
+    uint32_t n = shows;
+
+    while (shows < n + 2)
+        vTaskDelay(configTICK_RATE_HZ / OUTPUT_REFRESH_HZ);
+}
+
+static void test_task(void *arg)
+{
+    e131_universe_t *u = E131_getUniverse(1);
+
+    (void)arg;
+
+    /* Frames 40 ms apart, from dark to 200 */
+    receive(u, 1000, 0);
+    receive(u, 1040, 0);
+    receive(u, 1080, 200);
+    settle();
+    CHECK(shown[0] == 0 && shown[1] == 0 && shown[2] == 0);
+
+    /* Halfway to the next frame the blend is halfway from dark to 200 */
+    clock_ms = 1100;
+    settle();
+    CHECK(shown[0] > 0 && shown[0] < 200);
+    CHECK(shown[0] >= 95 && shown[0] <= 105);
+    CHECK(shown[1] == shown[0] && shown[2] == shown[0]);
+
+    /* An interval later the new frame is shown as is */
+    clock_ms = 1120;
+    settle();
+    CHECK(shown[0] == 200);
+
+    /* The next frame blends from 200, not from the dark one before it */
+    receive(u, 1120, 100);
+    clock_ms = 1140;
+    settle();
+    CHECK(shown[0] > 100 && shown[0] < 200);
+
+#if OUTPUT_MODE == OUTPUT_PARALLEL
+    /* Strand 1 lights up, then goes dark once the map drops it */
+    receive(E131_getUniverse(2), 1200, 200);
+    clock_ms = 1300;
+    settle();
+    CHECK(second[0] == 200 && second[1] == 200 && second[2] == 200);
+    CHECK(OUTPUT_SetMap(maps, 1) == 0);
+    settle();
+    CHECK(second[0] == 0 && second[1] == 0 && second[2] == 0);
+    CHECK(shown[0] == 100);
+#endif
+
+    vTaskEndScheduler();
+}
+
+int main(void)
+{
+    color_correction_t linear = { 1.0f, { 255, 255, 255, 255 } };
+    map_output_t m = { 1, 1, PIXELS, 0, 0, MAP_ORDER_GRB, 0, 0 };
+    map_output_t bad;
+
+    E131_init();
+    OUTPUT_Init();
+    OUTPUT_SetCorrection(0, &linear);
+#if OUTPUT_MODE == OUTPUT_PARALLEL
+    OUTPUT_SetCorrection(1, &linear);
+#endif
+
+    /* Invalid outputs leave the map alone */
+    bad = m;
+    bad.channel = 0;
+    CHECK(OUTPUT_SetMap(&bad, 1) == -1);
+    bad = m;
+    bad.zigzag = PIXELS + 1;
+    CHECK(OUTPUT_SetMap(&bad, 1) == -1);
+    bad = m;
+    bad.pixels = OUTPUT_PIXELS + 1;
+    CHECK(OUTPUT_SetMap(&bad, 1) == -1);
+    maps[0] = m;
+    maps[1] = m;
+    maps[1].universe = 2;
+#if OUTPUT_MODE == OUTPUT_PARALLEL
+    CHECK(OUTPUT_SetMap(maps, 2) == 0);
+#else
+    CHECK(OUTPUT_SetMap(maps, 1) == 0);
+#endif
+
+    if (xTaskCreate(test_task, "test", configMINIMAL_STACK_SIZE, NULL, 1, NULL) != pdPASS) {
+        printf("test_output: task creation failed\n");
+        return 1;
+    }
+    vTaskStartScheduler();
+
+    if (failures) {
+        printf("test_output: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_output: ok\n");
+    return 0;
+}
@@ -0,0 +1,258 @@
+/*
+ * test_pixel_map.c
+ *
+ *  Host test of the pixel mapping.  Every layout is applied universe by
+ *  universe through the compiled plan and compared with a pixel by pixel
+ *  reference.
+ *
+ *  cc -Isources tests/test_pixel_map.c sources/pixel_map.c -o test_pixel_map
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pixel_map.h"
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+#define UNIVERSES 8
+#define LEVELS 4096
+
+static uint8_t slots[UNIVERSES][MAP_SLOTS];
+static color_lut16_t lut;
+static map_plan_t plan;
+
+/* Wire channel c of each pixel, in source channel order per color order */
+static const char *orders[] = { "RGB", "RBG", "GRB", "GBR", "BRG", "BGR", "RGBW", "GRBW" };
+
+/* Pixel by pixel, straight from the description */
+static void reference(const map_output_t *o, uint8_t count, uint16_t *levels)
+{
+    const uint16_t *tab[4] = { lut.r, lut.g, lut.b, lut.w };
+    uint32_t g, s;
+    uint16_t p, run, pos, len, phys;
+    uint8_t n, k, c, channels;
+
+    for (n = 0; n < count; n++, o++) {
+        channels = MAP_ORDER_CHANNELS(o->order);
+        for (p = 0; p < o->pixels; p++) {
+            phys = p;
+            if (o->zigzag) {
+                run = p / o->zigzag;
+                pos = p % o->zigzag;
+                len = o->pixels - run * o->zigzag < o->zigzag ? o->pixels - run * o->zigzag : o->zigzag;
+                if (run & 1)
+                    phys = run * o->zigzag + len - 1 - pos;
+            }
+            if (o->reverse)
+                phys = o->pixels - 1 - phys;
+
+            g = o->channel - 1U + (o->universePixels ? (uint32_t)(p / o->universePixels) * MAP_SLOTS +
+                (uint32_t)(p % o->universePixels) * channels : (uint32_t)p * channels);
+            for (k = 0; k < channels; k++) {
+                c = (uint8_t)(strchr("RGBW", orders[o->order][k]) - "RGBW");
+                s = g + c;
+                levels[o->base + phys * channels + k] = tab[c][slots[o->universe - 1 + s / MAP_SLOTS][s % MAP_SLOTS]];
+            }
+        }
+    }
+}
+
+static void run(const map_output_t *o, uint8_t count)
+{
+    static uint16_t want[LEVELS], got[LEVELS];
+    const color_lut16_t *luts[MAP_MAX_OUTPUTS];
+    uint16_t *targets[MAP_MAX_OUTPUTS];
+    uint16_t u, i;
+    int same = 1;
+
+    for (i = 0; i < MAP_MAX_OUTPUTS; i++) {
+        luts[i] = &lut;
+        targets[i] = got;
+    }
+    memset(want, 0, sizeof(want));
+    memset(got, 0, sizeof(got));
+
+    CHECK(MAP_Compile(&plan, o, count) == 0);
+    reference(o, count, want);
+    for (u = 1; u <= UNIVERSES; u++)
+        MAP_Apply(&plan, u, slots[u - 1], MAP_SLOTS, luts, targets);
+    for (i = 0; i < LEVELS; i++)
+        same &= want[i] == got[i];
+    CHECK(same);
+}
+
+int main(void)
+{
+    static uint16_t got[LEVELS];
+    const color_lut16_t *luts[1] = { &lut };
+    uint16_t *targets[1] = { got };
+    map_output_t o[4];
+    uint32_t seed = 3;
+    uint16_t i, u;
+
+    /* Tables that tell the source channel and value apart */
+    for (i = 0; i < 256; i++) {
+        lut.r[i] = i;
+        lut.g[i] = 0x100 + i;
+        lut.b[i] = 0x200 + i;
+        lut.w[i] = 0x300 + i;
+    }
+    for (u = 0; u < UNIVERSES; u++) {
+        for (i = 0; i < MAP_SLOTS; i++) {
+            seed = seed * 1103515245U + 12345U;
+            slots[u][i] = (uint8_t)(seed >> 16);
+        }
+    }
+
+    /* 170 GRB pixels per universe, as the default map: one run per universe */
+    memset(o, 0, sizeof(o));
+    o[0].universe = 1;
+    o[0].channel = 1;
+    o[0].pixels = 340;
+    o[0].universePixels = 170;
+    o[0].order = MAP_ORDER_GRB;
+    run(o, 1);
+    CHECK(plan.ops == 2);
+    CHECK(plan.universe == 1 && plan.universes == 2);
+    CHECK(plan.lastUniverse[0] == 2);
+
+    /* Every order */
+    for (i = 0; i < 8; i++) {
+        o[0].order = (uint8_t)i;
+        o[0].universePixels = (uint16_t)(MAP_SLOTS / MAP_ORDER_CHANNELS(i));
+        run(o, 1);
+    }
+
+    /* RGBW packed across universes from slot 510: pixels straddle the edges */
+    o[0].channel = 510;
+    o[0].pixels = 400;
+    o[0].universePixels = 0;
+    o[0].order = MAP_ORDER_GRBW;
+    run(o, 1);
+    CHECK(plan.lastUniverse[0] == 5);
+
+    /* RGB packed, 512 isn't a multiple of 3 either */
+    o[0].channel = 1;
+    o[0].order = MAP_ORDER_RGB;
+    run(o, 1);
+
+    /* Serpentine runs of 16 with a short last run, reversed */
+    o[0].pixels = 100;
+    o[0].zigzag = 16;
+    run(o, 1);
+    o[0].reverse = 1;
+    run(o, 1);
+    o[0].channel = 300;
+    run(o, 1);
+
+    /* Several outputs sharing universes */
+    memset(o, 0, sizeof(o));
+    for (i = 0; i < 4; i++) {
+        o[i].universe = 2;
+        o[i].channel = (uint16_t)(1 + i * 150);
+        o[i].pixels = 50;
+        o[i].order = (uint8_t)(MAP_ORDER_RGB + i);
+        o[i].zigzag = (uint16_t)(i * 5);
+        o[i].reverse = (uint8_t)(i & 1);
+        o[i].base = (uint16_t)(i * 200);
+    }
+    o[3].universe = 3;
+    o[3].channel = 201;
+    o[3].pixels = 250;
+    o[3].universePixels = 100;
+    o[3].base = 800;
+    run(o, 4);
+    CHECK(plan.lastUniverse[0] == 2 && plan.lastUniverse[3] == 5);
+
+    /* Short packets leave the rest alone, also in a straddling pixel */
+    memset(o, 0, sizeof(o));
+    o[0].universe = 1;
+    o[0].channel = 505;
+    o[0].pixels = 20;
+    o[0].order = MAP_ORDER_RGB;
+    CHECK(MAP_Compile(&plan, o, 1) == 0);
+    for (i = 0; i < LEVELS; i++)
+        got[i] = 0xFFFF;
+    MAP_Apply(&plan, 2, slots[1], 10, luts, targets);
+    CHECK(got[8] == 0x200 + slots[1][0]);       /* Pixel 2 is 511 and 512 of universe 1, 1 of 2 */
+    CHECK(got[9] == slots[1][1] && got[11] == 0x200 + slots[1][3]);
+    CHECK(got[12] == slots[1][4] && got[14] == 0x200 + slots[1][6]);
+    CHECK(got[15] == slots[1][7] && got[17] == 0x200 + slots[1][9]);
+    CHECK(got[18] == 0xFFFF && got[5] == 0xFFFF);
+    MAP_Apply(&plan, 1, slots[0], 509, luts, targets);
+    CHECK(got[0] == slots[0][504] && got[2] == 0x200 + slots[0][506]);
+    CHECK(got[3] == 0xFFFF);                    /* Whole pixels only */
+
+    /* Universes outside the plan are ignored */
+    MAP_Apply(&plan, 9, slots[0], MAP_SLOTS, luts, targets);
+    CHECK(got[18] == 0xFFFF);
+
+    /* Too much for the plan */
+    memset(o, 0, sizeof(o));
+    o[0].universe = 1;
+    o[0].channel = 1;
+    o[0].pixels = 400;
+    o[0].zigzag = 1;
+    o[0].universePixels = 1;
+    CHECK(MAP_Compile(&plan, o, 1) == -1);
+
+    /* Invalid outputs are rejected, unused ones never are */
+    memset(o, 0, sizeof(o));
+    o[0].universe = 1;
+    o[0].channel = 1;
+    o[0].pixels = 20;
+    o[0].order = MAP_ORDER_RGB;
+    CHECK(MAP_Compile(&plan, o, 2) == 0);
+    o[1] = o[0];
+    o[1].channel = 0;                           /* Slots are 1 based */
+    CHECK(MAP_Compile(&plan, o, 2) == -1);
+    o[1].channel = MAP_SLOTS + 1;
+    CHECK(MAP_Compile(&plan, o, 2) == -1);
+    o[1].channel = 1;
+    o[1].universe = 0;
+    CHECK(MAP_Compile(&plan, o, 2) == -1);
+    o[1].universe = MAP_UNIVERSE_MAX;
+    o[1].channel = MAP_SLOTS - 2;               /* The last pixel ends in universe 64000 */
+    o[1].pixels = 2;
+    CHECK(MAP_Compile(&plan, o + 1, 1) == -1);
+    o[1].channel = MAP_SLOTS - 5;
+    CHECK(MAP_Compile(&plan, o + 1, 1) == 0);
+    o[1].universe = 1;
+    o[1].channel = 1;
+    o[1].pixels = 20;
+    o[1].order = MAP_ORDER_GRBW + 1;
+    CHECK(MAP_Compile(&plan, o, 2) == -1);
+    o[1].order = MAP_ORDER_RGB;
+    o[1].zigzag = 21;                           /* Runs longer than the output */
+    CHECK(MAP_Compile(&plan, o, 2) == -1);
+    o[1].zigzag = 20;
+    CHECK(MAP_Compile(&plan, o, 2) == 0);
+    o[1].channel = 304;                         /* 70 pixels a universe from slot 304 run past 512 */
+    o[1].universePixels = 70;
+    CHECK(MAP_Compile(&plan, o, 2) == -1);
+    o[1].universePixels = 69;
+    CHECK(MAP_Compile(&plan, o, 2) == 0);
+    o[1].base = 0xFFFF - 59;                    /* Levels past the 16 bit index */
+    CHECK(MAP_Compile(&plan, o, 2) == -1);
+    o[1].base = 0xFFFF - 60;
+    CHECK(MAP_Compile(&plan, o, 2) == 0);
+    o[1].pixels = 0;
+    o[1].channel = 0;
+    o[1].order = 0xFF;
+    CHECK(MAP_Compile(&plan, o, 2) == 0);
+
+    if (failures) {
+        printf("test_pixel_map: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_pixel_map: ok\n");
+    return 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * test_power.c
+ *
+ *  Host test of the current limiting.
+ *
+ *  cc -Isources tests/test_power.c sources/power.c sources/dither.c -o test_power
+ */
+
+#include <stdio.h>
+
+#include "power.h"
+#include "dither.h"
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+#define PIXELS 100
+
+int main(void)
+{
+    static uint16_t levels[PIXELS * 4];
+    static uint8_t out[PIXELS * 4];
+    power_budget_t budget = { { 20, 20, 20, 20 }, 1000, 0 };
+    power_stats_t stats;
+    uint32_t scale, sum;
+    int i;
+
+    POWER_ResetStats(&stats);
+
+    /* Full white RGB: 100 pixels x 60 mA + 100 mA idle */
+    for (i = 0; i < PIXELS * 3; i++)
+        levels[i] = 65535;
+    CHECK(POWER_Estimate(levels, PIXELS, 3, &budget) == 6100);
+    CHECK(POWER_Limit(levels, PIXELS, 3, &budget, &stats) == POWER_UNITY);
+    CHECK(stats.frames == 1 && stats.limited == 0 && stats.current == 6100);
+
+    /* RGBW counts the white LED as well, weights apply per channel */
+    for (i = 0; i < PIXELS * 4; i++)
+        levels[i] = (i % 4 == 3) ? 65535 : 0;
+    CHECK(POWER_Estimate(levels, PIXELS, 4, &budget) == 2100);
+    budget.mA[3] = 40;
+    CHECK(POWER_Estimate(levels, PIXELS, 4, &budget) == 4100);
+    budget.mA[3] = 20;
+
+    /* Over budget: the levels that depend on the data are scaled to fit */
+    for (i = 0; i < PIXELS * 3; i++)
+        levels[i] = 65535;
+    budget.budget = 3100;
+    scale = POWER_Limit(levels, PIXELS, 3, &budget, &stats);
+    CHECK(scale == POWER_UNITY / 2);
+    CHECK(stats.limited == 1 && stats.lowest == POWER_UNITY / 2 && stats.peak == 6100);
+
+    /* Applied by the dithering pass the result draws no more than the budget */
+    budget.budget = 2500;
+    scale = POWER_Limit(levels, PIXELS, 3, &budget, &stats);
+    DITHER_Round(levels, PIXELS * 3, scale, out);
+    for (sum = 0, i = 0; i < PIXELS * 3; i++)
+        sum += out[i];
+    CHECK(sum * 20U / 255U + 100U <= 2500U);
+    CHECK(sum * 20U / 255U + 100U >= 2450U);
+    CHECK(stats.limited == 2 && stats.lowest == scale);
+
+    /* Idle current alone over budget */
+    budget.budget = 50;
+    CHECK(POWER_Limit(levels, PIXELS, 3, &budget, &stats) == 0);
+
+    /* Dark frames never limit */
+    for (i = 0; i < PIXELS * 3; i++)
+        levels[i] = 0;
+    budget.budget = 200;
+    CHECK(POWER_Limit(levels, PIXELS, 3, &budget, &stats) == POWER_UNITY);
+    CHECK(stats.frames == 5 && stats.limited == 3 && stats.current == 100);
+
+    POWER_ResetStats(&stats);
+    CHECK(stats.frames == 0 && stats.peak == 0 && stats.lowest == POWER_UNITY);
+
+    if (failures) {
+        printf("test_power: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_power: ok\n");
+    return 0;
+}
@@ -0,0 +1,67 @@
+/*
+ * test_transpose.c
+ *
+ *  Host test of the bit-plane transposition against a bit-by-bit reference.
+ *
+ *  cc -Isources tests/test_transpose.c sources/pixel_transpose.c -o test_transpose
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pixel_transpose.h"
+
+#define BYTES 37
+#define STRIDE 41   /* Wider than BYTES, strands need not be packed */
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static uint16_t reference(const uint8_t *src, int strands, size_t i, int plane)
+{
+    uint16_t v = 0;
+    int s;
+
+    for (s = 0; s < strands; s++)
+        if (src[s * STRIDE + i] & (0x80 >> plane))
+            v |= (uint16_t)(1U << s);
+    return v;
+}
+
+int main(void)
+{
+    static uint8_t src[16 * STRIDE];
+    static uint8_t p8[BYTES * 8];
+    static uint16_t p16[BYTES * 8];
+    size_t i;
+    int b, round;
+
+    srand(1);
+    for (round = 0; round < 4; round++) {
+        for (i = 0; i < sizeof(src); i++)
+            src[i] = (uint8_t)(round == 0 ? (i & 1 ? 0xFF : 0x00) : rand());
+
+        PIXEL_Transpose8(src, STRIDE, BYTES, p8);
+        PIXEL_Transpose16(src, STRIDE, BYTES, p16);
+
+        for (i = 0; i < BYTES; i++) {
+            for (b = 0; b < 8; b++) {
+                CHECK(p8[i * 8 + b] == reference(src, 8, i, b));
+                CHECK(p16[i * 8 + b] == reference(src, 16, i, b));
+            }
+        }
+    }
+
+    if (failures) {
+        printf("test_transpose: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_transpose: ok\n");
+    return 0;
+}
@@ -0,0 +1,121 @@
+/*
+ * test_ws2812.c
+ *
+ *  Host test of the WS2812/SK6812 encoder: the compare values it produces
+ *  must give high times and bit periods inside the datasheet windows, and
+ *  the buffer must end with a long enough low line to latch the strip.
+ *
+ *  cc -Isources tests/test_ws2812.c sources/ws2812.c -o test_ws2812
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ws2812.h"
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+/* Spec windows in ns */
+typedef struct {
+    ws2812_type_t type;
+    uint32_t t0h_min, t0h_max;
+    uint32_t t1h_min, t1h_max;
+    uint32_t period_min, period_max;
+    uint32_t reset_min;
+} spec_t;
+
+static const spec_t specs[] = {
+    { kWS2812_TypeWS2812, 250, 550, 650, 950, 1250 - 600, 1250 + 600, 280000 },
+    { kWS2812_TypeSK6812, 150, 450, 450, 750, 1250 - 600, 1250 + 600, 80000 },
+};
+
+static const uint32_t clocks[] = { 48000000U, 60000000U, 120000000U };
+
+static uint32_t to_ns(uint32_t counts, uint32_t clock)
+{
+    return (uint32_t)((uint64_t)counts * 1000000000U / clock);
+}
+
+static void test_timing(void)
+{
+    ws2812_timing_t t;
+    size_t s, c;
+
+    for (s = 0; s < sizeof(specs) / sizeof(specs[0]); s++) {
+        for (c = 0; c < sizeof(clocks) / sizeof(clocks[0]); c++) {
+            const spec_t *sp = &specs[s];
+            uint32_t clock = clocks[c];
+            uint32_t period;
+
+            WS2812_GetTiming(&t, sp->type, clock);
+            period = to_ns(t.mod + 1U, clock);
+
+            CHECK(period >= sp->period_min && period <= sp->period_max);
+            CHECK(to_ns(t.t0h, clock) >= sp->t0h_min && to_ns(t.t0h, clock) <= sp->t0h_max);
+            CHECK(to_ns(t.t1h, clock) >= sp->t1h_min && to_ns(t.t1h, clock) <= sp->t1h_max);
+            CHECK(t.t0h > 0 && t.t1h <= t.mod);
+
+            /* The last period is cut short by the driver */
+            CHECK((uint64_t)(t.resetPeriods - 1U) * period >= sp->reset_min);
+            CHECK(t.resetPeriods <= WS2812_RESET_MAX_PERIODS);
+        }
+    }
+
+    /* Bus clock on this board */
+    WS2812_GetTiming(&t, kWS2812_TypeWS2812, 60000000U);
+    CHECK(t.mod == 74);
+    CHECK(t.t0h == 24);
+    CHECK(t.t1h == 48);
+}
+
+static void test_encode(void)
+{
+    static const uint8_t pixel[3] = { 0xA5, 0x00, 0xFF };
+    uint16_t cnv[WS2812_BUFFER_ENTRIES(sizeof(pixel)) + 1];
+    ws2812_timing_t t;
+    size_t n, i;
+
+    WS2812_GetTiming(&t, kWS2812_TypeWS2812, 60000000U);
+
+    memset(cnv, 0xEE, sizeof(cnv));
+    n = WS2812_Encode(&t, pixel, sizeof(pixel), cnv);
+
+    CHECK(n == sizeof(pixel) * 8 + t.resetPeriods);
+    CHECK(n <= WS2812_BUFFER_ENTRIES(sizeof(pixel)));
+
+    /* MSB first */
+    for (i = 0; i < 8; i++)
+        CHECK(cnv[i] == ((0xA5 >> (7 - i)) & 1 ? t.t1h : t.t0h));
+    for (i = 8; i < 16; i++)
+        CHECK(cnv[i] == t.t0h);
+    for (i = 16; i < 24; i++)
+        CHECK(cnv[i] == t.t1h);
+    for (i = 24; i < n; i++)
+        CHECK(cnv[i] == 0);
+
+    /* Nothing written past the returned length */
+    CHECK(cnv[n] == 0xEEEE);
+
+    /* An empty frame is just the latch */
+    CHECK(WS2812_Encode(&t, pixel, 0, cnv) == t.resetPeriods);
+}
+
+int main(void)
+{
+    test_timing();
+    test_encode();
+
+    if (failures) {
+        printf("test_ws2812: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_ws2812: ok\n");
+    return 0;
+}
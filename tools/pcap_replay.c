@@ -0,0 +1,357 @@
+/*
+ * pcap_replay.c
+ *
+ *  Feeds captured sACN traffic through the receive path as the board runs
+ *  it: every Ethernet frame of a pcap file goes into lwIP's
+ *  ethernet_input() through a stand-in netif, and from there through the
+ *  raw API listener (E131_lwip.c) into the E1.31 core.  The frames of
+ *  IPv4 UDP datagrams to the E1.31 port are readdressed to the stand-in,
+ *  unicast or multicast alike, so no group membership is needed.
+ *
+ *  Time is the capture's: sys_now() follows the frame timestamps, so source
+ *  timeouts and loss polling behave as they did on the wire.  By default
+ *  frames go in as fast as they can; -r paces them as they were captured.
+ *
+ *  pcap_replay [-r] [-d] [-u first,count] capture.pcap
+ *
+ *    -r  original timing
+ *    -d  dump the final contents of every universe that received data
+ *    -u  universe table, by default the range seen in the capture
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "E131_lwip.h"
+
+#include "lwip/etharp.h"
+#include "lwip/init.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+#include "lwip/timeouts.h"
+#include "netif/ethernet.h"
+
+#define PCAP_MAGIC 0xa1b2c3d4U             /* Microsecond timestamps */
+#define PCAP_MAGIC_NS 0xa1b23c4dU          /* Nanosecond timestamps */
+#define PCAP_LINKTYPE_ETHERNET 1
+#define PCAP_SNAPLEN 65535
+
+#define ETH_HEADER 14
+#define ETH_VLAN 0x8100
+#define ETH_IPV4 0x0800
+#define IP_UDP 17
+
+typedef struct _capture
+{
+    FILE *file;
+    int swap;                               /* Written on a host of the other byte order */
+    int nano;
+    uint32_t linktype;
+} capture_t;
+
+typedef struct _record
+{
+    uint64_t us;                            /* Timestamp */
+    uint32_t length;                        /* Bytes captured */
+    uint8_t data[PCAP_SNAPLEN];
+} record_t;
+
+static struct netif standin;
+static const uint8_t standin_mac[6] = { 0x02, 0x00, 0x00, 0x00, 0x13, 0x01 };
+static uint32_t clock_ms;                   /* Capture time, ms */
+
+static uint32_t latches[65536];             /* Callbacks per universe */
+static uint32_t lost[65536];                /* Loss callbacks per universe */
+
+u32_t sys_now(void)
+{
+    return clock_ms;
+}
+
+static uint32_t get32(const uint8_t *p, int swap)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return swap ? __builtin_bswap32(v) : v;
+}
+
+static int capture_open(capture_t *c, const char *path)
+{
+    uint8_t header[24];
+    uint32_t magic;
+
+    c->file = fopen(path, "rb");
+    if (!c->file) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (fread(header, sizeof(header), 1, c->file) != 1) {
+        fprintf(stderr, "%s: no pcap header\n", path);
+        return -1;
+    }
+
+    memcpy(&magic, header, sizeof(magic));
+    c->swap = magic == __builtin_bswap32(PCAP_MAGIC) || magic == __builtin_bswap32(PCAP_MAGIC_NS);
+    magic = get32(header, c->swap);
+    if (magic != PCAP_MAGIC && magic != PCAP_MAGIC_NS) {
+        fprintf(stderr, "%s: not a pcap file (pcapng is not supported)\n", path);
+        return -1;
+    }
+    c->nano = magic == PCAP_MAGIC_NS;
+    c->linktype = get32(header + 20, c->swap);
+    if (c->linktype != PCAP_LINKTYPE_ETHERNET) {
+        fprintf(stderr, "%s: link type %u, only Ethernet captures can be replayed\n", path, c->linktype);
+        return -1;
+    }
+    return 0;
+}
+
+/* Returns 1 for a record, 0 at the end */
+static int capture_next(capture_t *c, record_t *r)
+{
+    uint8_t header[16];
+    uint32_t caplen;
+
+    if (fread(header, sizeof(header), 1, c->file) != 1)
+        return 0;
+    caplen = get32(header + 8, c->swap);
+    r->us = (uint64_t)get32(header, c->swap) * 1000000U +
+            (c->nano ? get32(header + 4, c->swap) / 1000U : get32(header + 4, c->swap));
+    if (caplen > PCAP_SNAPLEN || fread(r->data, caplen, 1, c->file) != 1)
+        return 0;
+    r->length = caplen;
+    return 1;
+}
+
+/* Offset of the UDP header of an IPv4 datagram to the E1.31 port, 0 if it isn't one */
+static uint32_t sacn_udp(const uint8_t *f, uint32_t length, uint32_t *ip)
+{
+    uint32_t l3 = ETH_HEADER;
+    uint16_t type = (uint16_t)(f[12] << 8 | f[13]);
+    uint32_t ihl;
+
+    if (type == ETH_VLAN && length >= ETH_HEADER + 4) {
+        type = (uint16_t)(f[16] << 8 | f[17]);
+        l3 += 4;
+    }
+    if (type != ETH_IPV4 || length < l3 + 20 || f[l3 + 9] != IP_UDP)
+        return 0;
+    ihl = (f[l3] & 0x0fU) * 4U;
+    if (length < l3 + ihl + 8 || (f[l3 + ihl + 2] << 8 | f[l3 + ihl + 3]) != E131_DEFAULT_PORT)
+        return 0;
+    *ip = l3;
+    return l3 + ihl;
+}
+
+/* Range of universes in the capture, for the default table */
+static void scan(const char *path, uint16_t *first, uint16_t *count)
+{
+    static record_t r;
+    capture_t c;
+    uint32_t udp, ip, lo = 65535, hi = 0, u;
+
+    if (capture_open(&c, path))
+        exit(1);
+    while (capture_next(&c, &r)) {
+        udp = sacn_udp(r.data, r.length, &ip);
+        if (!udp || r.length < udp + 8 + E131_FRAME_UNIVERSE + 2)
+            continue;
+        u = (uint32_t)(r.data[udp + 8 + E131_FRAME_UNIVERSE] << 8 | r.data[udp + 8 + E131_FRAME_UNIVERSE + 1]);
+        if (u == 0 || r.data[udp + 8 + E131_ROOT_VECTOR + 3] != 4)
+            continue;
+        if (u < lo)
+            lo = u;
+        if (u > hi)
+            hi = u;
+    }
+    fclose(c.file);
+
+    if (lo > hi) {
+        *first = E131_DEFAULT_UNIVERSE;
+        *count = E131_DEFAULT_UNIVERSE_COUNT;
+        return;
+    }
+    *first = (uint16_t)lo;
+    *count = (uint16_t)(hi - lo + 1);
+    if (*count > E131_MAX_UNIVERSES) {
+        fprintf(stderr, "capture spans universes %u..%u, table limited to %u..%u\n", lo, hi, lo,
+                lo + E131_MAX_UNIVERSES - 1);
+        *count = E131_MAX_UNIVERSES;
+    }
+}
+
+static err_t standin_output(struct netif *netif, struct pbuf *p)
+{
+    LWIP_UNUSED_ARG(netif);
+    LWIP_UNUSED_ARG(p);
+    return ERR_OK;
+}
+
+static err_t standin_init(struct netif *netif)
+{
+    netif->name[0] = 'r';
+    netif->name[1] = 'p';
+    netif->mtu = 1500;
+    netif->hwaddr_len = 6;
+    memcpy(netif->hwaddr, standin_mac, 6);
+    netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET | NETIF_FLAG_IGMP;
+    netif->output = etharp_output;
+    netif->linkoutput = standin_output;
+    return ERR_OK;
+}
+
+static void received(e131_universe_t *u)
+{
+    latches[E131_universeNumber(u)]++;
+}
+
+static void loss(e131_universe_t *u, uint32_t elapsed, uint32_t step)
+{
+    LWIP_UNUSED_ARG(elapsed);
+    if (step == 0)
+        lost[E131_universeNumber(u)]++;
+}
+
+static double wall(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void dump(const e131_universe_t *u)
+{
+    uint16_t i;
+
+    for (i = 0; i < u->length; i++) {
+        if (i % 32 == 0)
+            printf("\n    %3u:", i);
+        printf(" %02x", u->data[i]);
+    }
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    static record_t r;
+    capture_t c;
+    ip4_addr_t ip, mask, gw;
+    struct pbuf *p;
+    e131_universe_t *u;
+    uint64_t start = 0, frames = 0, sacn = 0, dropped = 0;
+    uint32_t udp, l3, i;
+    uint16_t first = 0, count = 0;
+    double t0, elapsed;
+    int realtime = 0, dumping = 0, opt;
+    unsigned a, b;
+
+    while ((opt = getopt(argc, argv, "rdu:")) != -1) {
+        switch (opt) {
+        case 'r':
+            realtime = 1;
+            break;
+        case 'd':
+            dumping = 1;
+            break;
+        case 'u':
+            if (sscanf(optarg, "%u,%u", &a, &b) != 2 || a == 0 || b == 0 || b > E131_MAX_UNIVERSES) {
+                fprintf(stderr, "-u first,count with count 1..%u\n", E131_MAX_UNIVERSES);
+                return 2;
+            }
+            first = (uint16_t)a;
+            count = (uint16_t)b;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-r] [-d] [-u first,count] capture.pcap\n", argv[0]);
+            return 2;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "usage: %s [-r] [-d] [-u first,count] capture.pcap\n", argv[0]);
+        return 2;
+    }
+    if (!count)
+        scan(argv[optind], &first, &count);
+
+    lwip_init();
+    IP4_ADDR(&ip, 10, 13, 1, 2);
+    IP4_ADDR(&mask, 255, 255, 255, 0);
+    IP4_ADDR(&gw, 10, 13, 1, 1);
+    netif_add(&standin, &ip, &mask, &gw, NULL, standin_init, ethernet_input);
+    netif_set_default(&standin);
+    netif_set_up(&standin);
+    netif_set_link_up(&standin);
+
+    E131_init();
+    E131_setCallback(received);
+    E131_setLossCallback(loss);
+    E131_beginRaw(E131_UNICAST, first, (uint8_t)count);
+
+    if (capture_open(&c, argv[optind]))
+        return 1;
+
+    t0 = wall();
+    while (capture_next(&c, &r)) {
+        if (!frames)
+            start = r.us;
+        frames++;
+        clock_ms = (uint32_t)((r.us - start) / 1000U) + 1U;
+
+        if (realtime) {
+            elapsed = (r.us - start) / 1e6 - (wall() - t0);
+            if (elapsed > 0)
+                usleep((useconds_t)(elapsed * 1e6));
+        }
+
+        if (r.length < ETH_HEADER)
+            continue;
+        udp = sacn_udp(r.data, r.length, &l3);
+        if (udp) {
+            /* To the stand-in, whatever the datagram was addressed to */
+            sacn++;
+            memcpy(r.data, standin_mac, 6);
+            memcpy(r.data + l3 + 16, &ip, 4);
+        }
+
+        p = pbuf_alloc(PBUF_RAW, (u16_t)r.length, PBUF_POOL);
+        if (!p) {
+            dropped++;
+            continue;
+        }
+        pbuf_take(p, r.data, (u16_t)r.length);
+        if (standin.input(p, &standin) != ERR_OK)
+            pbuf_free(p);
+        sys_check_timeouts();
+    }
+    elapsed = wall() - t0;
+    fclose(c.file);
+
+    printf("\n%llu frames, %llu to port %u, %llu dropped, %.3f s of capture in %.3f s\n",
+           (unsigned long long)frames, (unsigned long long)sacn, E131_DEFAULT_PORT, (unsigned long long)dropped,
+           clock_ms / 1000.0, elapsed);
+    if (elapsed > 0)
+        printf("%.0f frames/s, %.0f sACN packets/s\n", frames / elapsed, sacn / elapsed);
+    printf("core: %u valid, %u packet errors, %u sequence errors, %u alternate start codes, %u discovery\n\n",
+           stats.num_packets, stats.packet_errors, stats.sequence_errors, stats.start_codes, stats.discovery);
+
+    printf("universe  packets  seqerr  latched  losses  sources  priority  slots\n");
+    for (i = 0; i < count; i++) {
+        u = E131_getUniverse((uint16_t)(first + i));
+        if (!u->stats.num_packets && !u->stats.sequence_errors)
+            continue;
+        printf("%8u %8u %7u %8u %7u %8u %9u %6u%s", first + i, u->stats.num_packets, u->stats.sequence_errors,
+               latches[first + i], lost[first + i], E131_liveSources(u, clock_ms), u->priority,
+               u->length ? u->length - 1 : 0, u->lost ? "  lost" : "");
+        if (dumping)
+            dump(u);
+        else
+            printf("\n");
+    }
+    return 0;
+}
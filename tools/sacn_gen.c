@@ -0,0 +1,395 @@
+/*
+ * sacn_gen.c
+ *
+ *  sACN load generator.  Sends a range of universes at a fixed rate from
+ *  one or more sources (CIDs), each with its own priority, and can damage
+ *  the streams the way a busy network does: sequence gaps, as if packets
+ *  were lost on the way, and reordering, a packet held back and sent after
+ *  the next one of its stream.  Packets are built in e131_packet_t.
+ *
+ *  With -l the generator is its own receiver: it listens on the loopback
+ *  interface with the E1.31 core behind the socket, and finishes with a
+ *  per universe report of what was sent against what the core accepted.
+ *  The exit status is 1 when the two disagree, so the run doubles as a test.
+ *
+ *  sacn_gen [-l] [-a address] [-u first,count] [-r rate] [-t seconds]
+ *           [-c sources] [-p priority,...] [-g percent] [-o percent]
+ *           [-s slots] [-S seed]
+ *
+ *    -l  loopback, receive and report (default address 127.0.0.1)
+ *    -a  destination, by default the multicast group of each universe
+ *    -u  universe range, default 1,8
+ *    -r  packets per second per universe and source, 0 as fast as possible
+ *    -t  duration in seconds, default 5
+ *    -c  sources, each sending every universe, default 1
+ *    -p  priority of each source in turn, the last one repeats
+ *    -g  percentage of packets skipped, leaving a sequence gap
+ *    -o  percentage of packets sent after the next one of their stream
+ *    -s  slots per packet, default 512
+ *    -S  random seed, runs with the same seed damage the same packets
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "E131.h"
+
+#define MAX_SOURCES 16
+#define RECV_BUFFER (4 * 1024 * 1024)
+
+/* One universe from one source */
+typedef struct _stream
+{
+    e131_packet_t packet;
+    e131_packet_t held;                     /* Reordered packet waiting for the next one */
+    uint8_t holding;
+    uint8_t sequence;
+    uint32_t sent;
+    uint32_t gaps;                          /* Sequence numbers skipped */
+    uint32_t late;                          /* Sent after a newer packet, stale at the receiver */
+} stream_t;
+
+static stream_t *streams;
+static uint16_t first = 1, count = 8;
+static uint8_t sources = 1;
+static uint8_t priorities[MAX_SOURCES];
+static uint16_t slots = 512;
+static uint16_t size;
+
+static int tx = -1, rx = -1;
+static struct sockaddr_in dest;
+static int unicast;
+static uint64_t transmitted;
+static uint32_t send_errors;
+
+static uint32_t *latches;                   /* Callbacks per universe */
+static uint64_t received;
+
+static double wall(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+uint32_t E131_now(void)
+{
+    return (uint32_t)(wall() * 1000.0);
+}
+
+static void latched(e131_universe_t *u)
+{
+    latches[E131_universeNumber(u) - first]++;
+}
+
+static void build(e131_packet_t *p, uint8_t source, uint16_t universe)
+{
+    uint16_t i;
+
+    memset(p, 0, sizeof(*p));
+    p->preamble_size = htons(0x0010);
+    p->postamble_size = 0;
+    memcpy(p->acn_id, ACN_ID, sizeof(p->acn_id));
+    p->root_flength = htons(0x7000 | (size - E131_ROOT_FLENGTH));
+    p->root_vector = htonl(VECTOR_ROOT);
+    memset(p->cid, 0x5a, sizeof(p->cid));
+    p->cid[15] = source;
+
+    p->frame_flength = htons(0x7000 | (size - E131_FRAME_FLENGTH));
+    p->frame_vector = htonl(VECTOR_FRAME);
+    snprintf((char *)p->source_name, sizeof(p->source_name), "sacn_gen %u", source);
+    p->priority = priorities[source];
+    p->universe = htons(universe);
+
+    p->dmp_flength = htons(0x7000 | (size - E131_DMP_FLENGTH));
+    p->dmp_vector = VECTOR_DMP;
+    p->type = 0xa1;
+    p->first_address = 0;
+    p->address_increment = htons(1);
+    p->property_value_count = htons(slots + 1);
+    for (i = 1; i <= slots; i++)
+        p->property_values[i] = (uint8_t)(i * 7 + universe + source);
+}
+
+static void transmit(const e131_packet_t *p)
+{
+    struct sockaddr_in to = dest;
+    uint16_t universe = ntohs(p->universe);
+
+    if (!unicast)
+        to.sin_addr.s_addr = htonl(0xefff0000U | universe);
+    if (sendto(tx, p->raw, size, 0, (const struct sockaddr *)&to, sizeof(to)) != size)
+        send_errors++;
+    else
+        transmitted++;
+}
+
+static void drain(void)
+{
+    static uint8_t buf[sizeof(e131_packet_t)];
+    ssize_t len;
+
+    if (rx < 0)
+        return;
+    while ((len = recv(rx, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+        received++;
+        E131_parseBuffer(buf, (uint16_t)len);
+    }
+}
+
+/* Next packet of a stream, with the damage asked for */
+static void step(stream_t *s, unsigned gap, unsigned reorder, unsigned *seed)
+{
+    if ((unsigned)rand_r(seed) % 100 < gap) {
+        s->sequence++;
+        s->gaps++;
+        return;
+    }
+
+    s->packet.sequence_number = s->sequence++;
+    s->packet.property_values[1] = s->packet.sequence_number;
+
+    if (s->holding) {
+        transmit(&s->packet);
+        transmit(&s->held);
+        s->holding = 0;
+        s->late++;
+        s->sent += 2;
+    } else if ((unsigned)rand_r(seed) % 100 < reorder) {
+        s->held = s->packet;
+        s->holding = 1;
+    } else {
+        transmit(&s->packet);
+        s->sent++;
+    }
+}
+
+static int report(double elapsed)
+{
+    e131_universe_t *u;
+    uint64_t sent = 0, late = 0, passed = 0;
+    uint32_t expect, seqerr, i, n;
+    int mismatch = 0;
+
+    drain();
+
+    printf("\nuniverse     sent     gaps     late   passed   seqerr  latched\n");
+    for (i = 0; i < count; i++) {
+        stream_t *s = &streams[i * sources];
+        uint32_t usent = 0, ugaps = 0, ulate = 0;
+
+        for (n = 0; n < sources; n++) {
+            usent += s[n].sent;
+            ugaps += s[n].gaps;
+            ulate += s[n].late;
+        }
+        u = E131_getUniverse((uint16_t)(first + i));
+        expect = usent - ulate;
+        seqerr = u->stats.sequence_errors;
+        printf("%8u %8u %8u %8u %8u %8u %8u%s\n", first + i, usent, ugaps, ulate, u->stats.num_packets, seqerr,
+               latches[i], u->stats.num_packets != expect || seqerr != ulate ? "  mismatch" : "");
+        if (u->stats.num_packets != expect || seqerr != ulate)
+            mismatch = 1;
+        sent += usent;
+        late += ulate;
+        passed += u->stats.num_packets;
+    }
+
+    printf("\n%llu sent, %llu received, %llu expected to pass, %llu passed, %u packet errors\n",
+           (unsigned long long)sent, (unsigned long long)received, (unsigned long long)(sent - late),
+           (unsigned long long)passed, stats.packet_errors);
+    if (elapsed > 0)
+        printf("%.0f packets/s received and parsed\n", received / elapsed);
+    return mismatch || received != sent || stats.packet_errors;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-l] [-a address] [-u first,count] [-r rate] [-t seconds] [-c sources]\n"
+                    "       [-p priority,...] [-g percent] [-o percent] [-s slots] [-S seed]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    struct sockaddr_in local;
+    double rate = 44, duration = 5, t0, next, elapsed;
+    unsigned gap = 0, reorder = 0, seed = 1, a, b, i, n;
+    uint64_t ticks = 0;
+    int loopback = 0, opt, one = 1, bufsize = RECV_BUFFER;
+    char *p;
+
+    for (i = 0; i < MAX_SOURCES; i++)
+        priorities[i] = E131_PRIORITY_DEFAULT;
+
+    memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(E131_DEFAULT_PORT);
+
+    while ((opt = getopt(argc, argv, "la:u:r:t:c:p:g:o:s:S:")) != -1) {
+        switch (opt) {
+        case 'l':
+            loopback = 1;
+            break;
+        case 'a':
+            if (inet_pton(AF_INET, optarg, &dest.sin_addr) != 1) {
+                fprintf(stderr, "-a takes an IPv4 address\n");
+                return 2;
+            }
+            unicast = 1;
+            break;
+        case 'u':
+            if (sscanf(optarg, "%u,%u", &a, &b) != 2 || a == 0 || b == 0 || b > E131_MAX_UNIVERSES ||
+                a + b - 1 > 63999) {
+                fprintf(stderr, "-u first,count with count 1..%u\n", E131_MAX_UNIVERSES);
+                return 2;
+            }
+            first = (uint16_t)a;
+            count = (uint16_t)b;
+            break;
+        case 'r':
+            rate = atof(optarg);
+            break;
+        case 't':
+            duration = atof(optarg);
+            break;
+        case 'c':
+            a = (unsigned)atoi(optarg);
+            if (a == 0 || a > MAX_SOURCES) {
+                fprintf(stderr, "-c takes 1..%u sources\n", MAX_SOURCES);
+                return 2;
+            }
+            sources = (uint8_t)a;
+            break;
+        case 'p':
+            for (i = 0, p = optarg; i < MAX_SOURCES; i++) {
+                priorities[i] = (uint8_t)strtoul(p, &p, 10);
+                if (*p != ',')
+                    break;
+                p++;
+            }
+            for (n = i + 1; n < MAX_SOURCES; n++)
+                priorities[n] = priorities[i];
+            break;
+        case 'g':
+            gap = (unsigned)atoi(optarg);
+            break;
+        case 'o':
+            reorder = (unsigned)atoi(optarg);
+            break;
+        case 's':
+            a = (unsigned)atoi(optarg);
+            if (a == 0 || a > E131_UNIVERSE_SIZE - 1) {
+                fprintf(stderr, "-s takes 1..%u slots\n", E131_UNIVERSE_SIZE - 1);
+                return 2;
+            }
+            slots = (uint16_t)a;
+            break;
+        case 'S':
+            seed = (unsigned)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (optind != argc || rate < 0 || duration <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (loopback && !unicast) {
+        dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        unicast = 1;
+    }
+    if (loopback && sources > E131_MAX_SOURCES)
+        fprintf(stderr, "%u sources, the core tracks %u per universe: expect mismatches\n", sources,
+                E131_MAX_SOURCES);
+
+    size = (uint16_t)(E131_DMP_DATA + slots + 1);
+    streams = calloc((size_t)count * sources, sizeof(*streams));
+    latches = calloc(count, sizeof(*latches));
+    if (!streams || !latches)
+        return 1;
+    for (i = 0; i < count; i++)
+        for (n = 0; n < sources; n++)
+            build(&streams[i * sources + n].packet, (uint8_t)n, (uint16_t)(first + i));
+
+    if (loopback) {
+        E131_init();
+        E131_setUniverses(first, (uint8_t)count);
+        E131_setCallback(latched);
+
+        rx = socket(AF_INET, SOCK_DGRAM, 0);
+        memset(&local, 0, sizeof(local));
+        local.sin_family = AF_INET;
+        local.sin_port = dest.sin_port;
+        local.sin_addr.s_addr = dest.sin_addr.s_addr;
+        setsockopt(rx, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        setsockopt(rx, SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof(bufsize));
+        if (rx < 0 || bind(rx, (const struct sockaddr *)&local, sizeof(local)) < 0) {
+            perror("receive socket");
+            return 1;
+        }
+    }
+
+    tx = socket(AF_INET, SOCK_DGRAM, 0);
+    if (tx < 0) {
+        perror("send socket");
+        return 1;
+    }
+    if (!unicast)
+        setsockopt(tx, IPPROTO_IP, IP_MULTICAST_TTL, &one, sizeof(one));
+
+    printf("%u universes from %u, %u source%s, %u slots, ", count, first, sources, sources > 1 ? "s" : "", slots);
+    if (rate)
+        printf("%.0f packets/s each, %.1f s\n", rate, duration);
+    else
+        printf("unpaced, %.1f s\n", duration);
+
+    t0 = next = wall();
+    while ((elapsed = wall() - t0) < duration) {
+        if (rate) {
+            struct timespec ts;
+            double wait = next - wall();
+
+            if (wait > 0) {
+                drain();
+                ts.tv_sec = (time_t)wait;
+                ts.tv_nsec = (long)((wait - ts.tv_sec) * 1e9);
+                nanosleep(&ts, NULL);
+            }
+            next += 1.0 / rate;
+        }
+
+        /* Every stream steps once a tick, universes interleaved across sources */
+        for (i = 0; i < count; i++) {
+            for (n = 0; n < sources; n++)
+                step(&streams[i * sources + n], gap, reorder, &seed);
+            drain();
+        }
+        ticks++;
+    }
+
+    /* Packets still held go out last, nothing newer follows them */
+    for (i = 0; i < (unsigned)count * sources; i++) {
+        if (streams[i].holding) {
+            transmit(&streams[i].held);
+            streams[i].holding = 0;
+            streams[i].sent++;
+        }
+    }
+    elapsed = wall() - t0;
+
+    printf("%llu ticks in %.3f s, %.0f packets/s sent, %u send errors\n", (unsigned long long)ticks, elapsed,
+           transmitted / elapsed, send_errors);
+
+    if (!loopback)
+        return send_errors != 0;
+    return report(elapsed) || send_errors;
+}